@@ -88,6 +88,11 @@ namespace divine::cc
             mapVirtualFile( brq::join_path( "/builtin/", src->n ), src->c );
     }
 
+    CC1::CC1( const CC1 &fs, std::shared_ptr< llvm::LLVMContext > ctx ) :
+        divineVFS( fs.divineVFS ), overlayFS( fs.overlayFS ),
+        ctx( ctx ? ctx : std::make_shared< llvm::LLVMContext >() )
+    {}
+
     CC1::~CC1() { }
 
     void CC1::mapVirtualFile( std::string path, std::string contents )
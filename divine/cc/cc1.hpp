@@ -66,6 +66,11 @@ namespace divine::cc
     struct CC1
     {
         explicit CC1( std::shared_ptr< llvm::LLVMContext > ctx = nullptr );
+
+        /* A compiler with a context of its own, but sharing the (virtual)
+         * file system with 'fs', for compiling in another thread. The file
+         * system must not be changed while both compilers are in use. */
+        CC1( const CC1 &fs, std::shared_ptr< llvm::LLVMContext > ctx );
         ~CC1();
 
         void mapVirtualFile( std::string path, std::string_view contents );
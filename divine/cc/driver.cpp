@@ -19,9 +19,15 @@
 #include <divine/cc/driver.hpp>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Program.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 
 #include <brick-string>
 #include <brick-types>
+#include <brick-sha2>
+
+#include <atomic>
+#include <exception>
+#include <sstream>
 
 namespace divine::cc
 {
@@ -122,18 +128,140 @@ namespace divine::cc
         return mod;
     }
 
+    std::string Driver::compile_tu( CC1 &cc, const File &f, const std::vector< std::string > &flags )
+    {
+        if ( opts.cache_dir.empty() )
+            return CC1::serializeModule( *cc.compile( f.name, f.type, flags ) );
+
+        std::stringstream key;
+        auto str = [&]( std::string_view s ) { key << s.size() << ":" << s << ";"; };
+
+        str( opts.build ), str( brq::getcwd() ), str( f.name ), key << int( f.type ) << ";";
+        for ( auto &flag : flags )
+            str( flag );
+        str( cc.preprocess( f.name, f.type, flags ) );
+
+        auto path = brq::join_path( opts.cache_dir, brq::to_hex( brq::sha2_256( key.str() ) ) + ".bc" );
+        if ( brq::file_exists( path ) )
+        {
+            /* a damaged entry (e.g. a truncated file) is replaced */
+            auto bc = brq::read_file( path );
+            auto parsed = llvm::parseBitcodeFile( llvm::MemoryBufferRef( bc, path ), *cc.context() );
+            if ( parsed )
+                return bc;
+            llvm::consumeError( parsed.takeError() );
+            try { brq::deleteIfExists( path ); } catch ( std::exception & ) {}
+        }
+
+        auto bc = CC1::serializeModule( *cc.compile( f.name, f.type, flags ) );
+
+        try
+        {
+            auto tmp = brq::temp_name( path );
+            brq::create_dir( opts.cache_dir );
+            brq::write_file( tmp, bc );
+            brq::rename_if_exists( tmp, path );
+        }
+        catch ( std::exception & ) {} /* failing to fill the cache is not fatal */
+
+        return bc;
+    }
+
+    std::vector< Driver::ModulePtr > Driver::compile_all( std::vector< File > files,
+                                                          std::vector< std::string > flags )
+    {
+        std::vector< std::string > allFlags = commonFlags;
+        std::copy( flags.begin(), flags.end(), std::back_inserter( allFlags ) );
+
+        /* the file system must be set up before the workers start */
+        compiler.allowIncludePath( "." );
+        for ( auto &f : files )
+        {
+            if ( f.type == FileType::Unknown )
+                throw std::runtime_error( "cannot detect file format for file '"
+                                          + f.name + "', please supply -x option for it" );
+            compiler.allowIncludePath( brq::dirname( f.name ) );
+        }
+
+        std::vector< ModulePtr > rv( files.size() );
+        std::vector< std::string > bitcode( files.size() );
+        std::vector< std::exception_ptr > errors( files.size() );
+        std::atomic< size_t > next = 0;
+
+        size_t jobs = opts.jobs > 0 ? opts.jobs : std::thread::hardware_concurrency();
+        jobs = std::max< size_t >( 1, std::min( jobs, files.size() ) );
+
+        if ( jobs == 1 && opts.cache_dir.empty() ) /* avoid the detour through bitcode */
+        {
+            for ( size_t i = 0; i < files.size(); ++i )
+                rv[ i ] = compile( files[ i ].name, files[ i ].type, flags );
+            return rv;
+        }
+
+        auto worker = [&]( CC1 &cc )
+        {
+            for ( size_t i; ( i = next++ ) < files.size(); )
+                try
+                {
+                    if ( opts.verbose )
+                        std::cerr << "compiling " << files[ i ].name << std::endl;
+                    bitcode[ i ] = compile_tu( cc, files[ i ], allFlags );
+                }
+                catch ( ... )
+                {
+                    errors[ i ] = std::current_exception();
+                }
+        };
+
+        std::vector< std::thread > threads;
+        for ( size_t i = 1; i < jobs; ++i )
+            threads.emplace_back( [&]
+            {
+                CC1 cc( compiler, nullptr );
+                worker( cc );
+            } );
+
+        CC1 cc( compiler, nullptr );
+        worker( cc );
+        for ( auto &t : threads )
+            t.join();
+
+        for ( size_t i = 0; i < files.size(); ++i )
+        {
+            if ( errors[ i ] )
+                std::rethrow_exception( errors[ i ] );
+
+            llvm::MemoryBufferRef buf( bitcode[ i ], files[ i ].name );
+            auto parsed = llvm::parseBitcodeFile( buf, *context() );
+            if ( !parsed )
+                throw CompileError( "could not load the bitcode of " + files[ i ].name + ": " +
+                                    llvm::toString( parsed.takeError() ) );
+            rv[ i ] = std::move( parsed.get() );
+        }
+
+        return rv;
+    }
+
     // Compile all the files and link them together, including necessary libraries
     void Driver::build( ParsedOpts po )
     {
         for ( auto path : po.allowedPaths )
             compiler.allowIncludePath( path );
 
+        std::vector< File > sources;
+        for ( auto &f : po.files )
+            if ( f.is< File >() )
+                sources.push_back( f.get< File >() );
+
+        auto modules = compile_all( sources, po.opts );
+        auto next = modules.begin();
+
         for ( auto &f : po.files )
         {
             f.match(
-                [&]( const File &f )
+                [&]( const File & )
                 {
-                    if ( auto m = compile( f.name, f.type, po.opts ) )
+                    if ( auto m = std::move( *next++ ) )
                         linker->link( std::move( m ) );
                 },
                 [&]( const Lib &l )
@@ -90,6 +90,17 @@ namespace divine::cc
         ModulePtr compile( std::string path, std::vector< std::string > flags = {} );
         ModulePtr compile( std::string path, FileType type, std::vector< std::string > flags = {} );
 
+        /* Compile a number of translation units, in parallel (see
+         * Options::jobs), each in a CC1 with a context of its own. The
+         * resulting modules are moved into our context (via bitcode) and
+         * returned in the same order as the input files. If Options::cache_dir
+         * is set, the bitcode of each unit is looked up in (and stored into)
+         * the cache, keyed on its preprocessed source, the flags and the
+         * build. */
+        std::vector< ModulePtr > compile_all( std::vector< File > files,
+                                              std::vector< std::string > flags = {} );
+        std::string compile_tu( CC1 &cc, const File &f, const std::vector< std::string > &flags );
+
         virtual void build( ParsedOpts po );
 
         std::unique_ptr< llvm::Module > takeLinked();
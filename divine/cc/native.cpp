@@ -22,6 +22,10 @@
 #include <divine/cc/native.hpp>
 #include <divine/cc/options.hpp>
 #include <iterator> // std::next
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 DIVINE_RELAX_WARNINGS
 #include "lld/Common/Driver.h"
@@ -41,21 +45,56 @@ namespace divine::cc
         _clang.allowIncludePath( "/" );
     }
 
-    // Compile all files that are neither libraries nor already object files
+    // Compile all files that are neither libraries nor already object files;
+    // each worker thread uses a compiler (and an LLVM context) of its own
     int Native::compile_files()
     {
+        PairedFiles todo;
         for ( auto file : _files )
+            if ( file.first != "lib" && !cc::is_object_type( file.first ) )
+                todo.push_back( file );
+
+        auto drv_args = _po.cc1_args;
+        add( drv_args, _po.opts );
+
+        std::atomic< size_t > next = 0;
+        std::exception_ptr error;
+        std::mutex error_mtx;
+
+        auto worker = [&]( cc::CC1 &clang )
         {
-            if ( file.first == "lib" )
-                continue;
-            if ( cc::is_object_type( file.first ) )
-                continue;
-            auto drv_args = _po.cc1_args;
-            add( drv_args, _po.opts );
-            TRACE( "compile:", file.first, drv_args );
-            auto mod = _clang.compile( file.first, drv_args );
-            cc::emit_obj_file( *mod, file.second, _po.pic );
-        }
+            for ( size_t i; ( i = next++ ) < todo.size(); )
+                try
+                {
+                    TRACE( "compile:", todo[ i ].first, drv_args );
+                    auto mod = clang.compile( todo[ i ].first, drv_args );
+                    cc::emit_obj_file( *mod, todo[ i ].second, _po.pic );
+                }
+                catch ( ... )
+                {
+                    std::lock_guard< std::mutex > _lock( error_mtx );
+                    if ( !error )
+                        error = std::current_exception();
+                    next = todo.size();
+                }
+        };
+
+        size_t jobs = _po.jobs > 0 ? _po.jobs : std::thread::hardware_concurrency();
+        jobs = std::max< size_t >( 1, std::min( jobs, todo.size() ) );
+        std::vector< std::thread > threads;
+        for ( size_t i = 1; i < jobs; ++i )
+            threads.emplace_back( [&]
+            {
+                cc::CC1 clang( _clang, nullptr );
+                worker( clang );
+            } );
+
+        worker( _clang );
+        for ( auto &t : threads )
+            t.join();
+
+        if ( error )
+            std::rethrow_exception( error );
         return 0;
     }
 
@@ -15,6 +15,9 @@
 #include <divine/cc/options.hpp>
 #include <brick-string>
 
+#include <cstdlib>
+#include <limits>
+
 namespace divine::cc
 {
     // Parse CLI options (switches and files) and process them into a form understood by the driver
@@ -111,6 +114,22 @@ namespace divine::cc
             }
             else if ( *it == "--use-lld" )
                 po.use_lld = true;
+            else if ( *it == "--jobs" || brq::starts_with( *it, "--jobs=" ) )
+            {
+                std::string val;
+                if ( *it != "--jobs" )
+                    val = it->substr( 7 );
+                else if ( it + 1 != end )
+                    val = *++it;
+                else
+                    throw std::runtime_error( "--jobs requires a value" );
+
+                char *rest;
+                long n = std::strtol( val.c_str(), &rest, 10 );
+                if ( val.empty() || *rest || n < 0 || n > std::numeric_limits< int >::max() )
+                    throw std::runtime_error( "--jobs value not a number: " + val );
+                po.jobs = n;
+            }
             else if ( *it == "-g" )
                 po.opts.emplace_back( "-debug-info-kind=standalone" );
             else if ( *it == "-static" || *it == "--static" )
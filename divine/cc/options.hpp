@@ -25,6 +25,9 @@ namespace divine::cc
     {
         brq::cmd_flag dont_link;
         bool verbose;
+        int jobs = 0;          /* translation units compiled in parallel, 0 = one per CPU */
+        std::string cache_dir; /* keep compiled translation units here, if not empty */
+        std::string build;     /* identifies the compiler, part of the cache key */
         Options() : Options( false, true ) {}
         Options( bool dont_link, bool verbose ) : dont_link( dont_link ), verbose( verbose ) {}
     };
@@ -46,6 +49,7 @@ namespace divine::cc
         bool use_lld = false;
         bool shared = false;
         bool pic = false;
+        int jobs = 0; /* --jobs, see Native::compile_files */
     };
 
     ParsedOpts parseOpts( std::vector< std::string > rawCCOpts );
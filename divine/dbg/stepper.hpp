@@ -37,6 +37,7 @@ struct Stepper
     using YieldState = std::function< Snapshot( Snapshot ) >;
     using CallBack = std::function< bool() >;
     using Breakpoint = std::function< bool( vm::CodePointer, bool ) >;
+    using Progress = std::function< bool( Context &, vm::CodePointer, int64_t ) >;
 
     vm::GenericPointer _frame, _frame_cur, _parent_cur;
     llvm::Instruction *_insn_last;
@@ -46,11 +47,18 @@ struct Stepper
     int _columns = 80;
     std::pair< int, int > _lines, _instructions, _states, _jumps;
     std::pair< llvm::StringRef, int > _line;
+    int64_t _executed = 0; /* instructions executed outside of _ff_components */
 
     Breakpoint _breakpoint;
     YieldState _yield_state;
     CallBack _callback;
 
+    /* Called right before each instruction which counts towards _executed,
+     * with the pc and the number of such instructions executed so far;
+     * returning true stops the stepper at that point. This is what 'sim'
+     * uses to take checkpoints and to replay up to a given position. */
+    Progress _progress;
+
     Stepper()
         : _frame( vm::nullPointer() ),
           _frame_cur( vm::nullPointer() ),
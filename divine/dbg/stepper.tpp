@@ -58,6 +58,7 @@ void Stepper< Context >::run( Context &ctx, Verbosity verb )
     bool error_set = !_stop_on_error || ctx.flags_any( _VM_CF_Error );
     bool moved = false, in_fault, rewind_to_fault = false;
     Context _backup( ctx.program(), ctx.debug() );
+    int64_t _backup_executed = 0;
 
     if ( auto insn = ctx.debug().find( nullptr, ctx.program().advance( eval.pc() ) ).first )
         _line = dbg::fileline( *insn );
@@ -69,7 +70,7 @@ void Stepper< Context >::run( Context &ctx, Verbosity verb )
         if ( !error_set && ctx.flags_any( _VM_CF_Error ) )
         {
             if ( rewind_to_fault )
-                ctx = _backup;
+                ctx = _backup, _executed = _backup_executed;
             ctx.flush_ptr2i();
             break;
         }
@@ -82,6 +83,7 @@ void Stepper< Context >::run( Context &ctx, Verbosity verb )
             rewind_to_fault = true;
             ctx.snapshot();
             _backup = ctx;
+            _backup_executed = _executed;
             ctx.flush_ptr2i();
         }
 
@@ -101,9 +103,13 @@ void Stepper< Context >::run( Context &ctx, Verbosity verb )
             if ( _stop_on_fault && in_fault )
                 break;
 
+            if ( _progress && _progress( ctx, eval.pc(), _executed ) )
+                break;
+
             in_frame( ctx.frame(), ctx.heap() );
             eval.advance();
             instruction();
+            ++ _executed;
         }
 
         moved = true;
@@ -145,9 +145,8 @@ void fillSets( Node* node, LTLPtr form,
     }
 }
 
-bool ltlEquals( LTLPtr f1, LTLPtr f2 ) {
-    LTLComparator c;
-    return !c(f1, f2) && !c(f2, f1);
+bool ltlEquals( LTLPtr f1, LTLPtr f2 ) { // formulae are hash-consed
+    return f1 == f2;
 }
 
 StatePtr Node::findTwin( const std::set< StatePtr, State::Comparator >& states )
@@ -340,7 +339,7 @@ TGBA1::TGBA1( const TGBA2& _tgba2 )
             for( const auto& transition : _tgba2.states.at( stateId ) ) {
                 std::vector< bool > acc;
                 acc.resize( _tgba2.nAcceptingSets, false );
-                for( bool index : transition.accepting )
+                for( size_t index : transition.accepting )
                     acc.at( index ) = true;
                 states.at( transition.target )->addEdge( sources, emptyLabel, acc );
             }
@@ -21,6 +21,9 @@
 #include <cassert>
 #include <stack>
 #include <fstream>
+#include <limits>
+#include <functional>
+#include <mutex>
 
 #ifndef LTL2C_BUCHI_H
 #define LTL2C_BUCHI_H
@@ -697,14 +700,9 @@ static inline TGBA2 HOAParser( const std::string& filename )
 
 static inline TGBA1 ltlToTGBA1( LTLPtr _formula, bool negate )
 {
-    LTLPtr formula = _formula;
-    LTL::Simplifier simplifier( true );
-    while( simplifier.changed )
-    {
-        simplifier = LTL::Simplifier( false );
-        formula = simplifier.makeSimpler( formula );
-    }
+    LTLPtr formula = LTL::Simplifier::simplest( _formula );
     formula = formula->normalForm( negate );
+    formula->clearLabels();
     uCount = formula->countAndLabelU();
     formula->computeUParents();
 
@@ -718,6 +716,252 @@ static inline TGBA1 ltlToTGBA1( LTLPtr _formula, bool negate )
     return tbga;
 }
 
+/*
+ * Language-preserving reductions of a translated automaton:
+ *  - SCC pruning: states from which no accepting SCC can be reached are
+ *    removed, and acceptance marks are dropped from transitions outside of
+ *    accepting SCCs, since those can only be taken finitely often,
+ *  - states which simulate each other (direct simulation, where the
+ *    simulating state must match each transition by a single transition
+ *    with a weaker label and at least the same marks) are merged,
+ *  - transitions dominated by another transition of the same state (which
+ *    is enabled whenever it is, carries at least its marks and leads to a
+ *    state which simulates its target) are removed.
+ * States are renumbered in BFS order, so that the initial state is 0.
+ */
+struct Reduction
+{
+    using Label = std::set< std::pair< bool, size_t > >;
+    using Marks = std::set< size_t >;
+    using Sim = std::vector< std::vector< bool > >;
+
+    TGBA2 &a;
+    Reduction( TGBA2 &_a ) : a( _a ) {}
+
+    // is every valuation which satisfies b also a model of a?
+    static bool weaker( const Label &a, const Label &b )
+    {
+        return std::includes( b.begin(), b.end(), a.begin(), a.end() );
+    }
+
+    static bool covers( const Marks &a, const Marks &b )
+    {
+        return std::includes( a.begin(), a.end(), b.begin(), b.end() );
+    }
+
+    bool dominates( const Transition &u, const Transition &t, const Sim &sim )
+    {
+        return weaker( u.label, t.label ) && covers( u.accepting, t.accepting ) && sim[ t.target ][ u.target ];
+    }
+
+    // scc[ s ] is the index of the SCC of s, in reverse topological order
+    std::vector< size_t > sccs()
+    {
+        size_t n = a.states.size(), counter = 0, count = 0;
+        std::vector< size_t > index( n, 0 ), low( n, 0 ), scc( n, n );
+        std::vector< size_t > stack;
+
+        std::function< void( size_t ) > visit = [&]( size_t s )
+        {
+            index[ s ] = low[ s ] = ++counter;
+            stack.push_back( s );
+            for ( auto &t : a.states[ s ] )
+                if ( !index[ t.target ] )
+                {
+                    visit( t.target );
+                    low[ s ] = std::min( low[ s ], low[ t.target ] );
+                }
+                else if ( scc[ t.target ] == n )
+                    low[ s ] = std::min( low[ s ], index[ t.target ] );
+            if ( low[ s ] == index[ s ] )
+            {
+                size_t t;
+                do {
+                    t = stack.back();
+                    stack.pop_back();
+                    scc[ t ] = count;
+                } while ( t != s );
+                ++ count;
+            }
+        };
+
+        for ( size_t s = 0; s < n; ++s )
+            if ( !index[ s ] )
+                visit( s );
+        return scc;
+    }
+
+    void prune()
+    {
+        auto scc = sccs();
+        size_t n = a.states.size(), count = 0;
+        for ( auto c : scc )
+            count = std::max( count, c + 1 );
+
+        std::vector< Marks > marks( count );
+        std::vector< bool > cycle( count, false ), useful( count, false );
+        for ( size_t s = 0; s < n; ++s )
+            for ( auto &t : a.states[ s ] )
+                if ( scc[ t.target ] == scc[ s ] )
+                {
+                    cycle[ scc[ s ] ] = true;
+                    marks[ scc[ s ] ].insert( t.accepting.begin(), t.accepting.end() );
+                }
+
+        // successor SCCs have smaller indices, so one pass in order is enough
+        std::vector< std::vector< size_t > > states( count );
+        for ( size_t s = 0; s < n; ++s )
+            states[ scc[ s ] ].push_back( s );
+        for ( size_t c = 0; c < count; ++c )
+        {
+            useful[ c ] = cycle[ c ] && marks[ c ].size() == a.nAcceptingSets;
+            for ( size_t s : states[ c ] )
+                for ( auto &t : a.states[ s ] )
+                    useful[ c ] = useful[ c ] || useful[ scc[ t.target ] ];
+        }
+
+        for ( size_t s = 0; s < n; ++s )
+        {
+            auto &ts = a.states[ s ];
+            ts.erase( std::remove_if( ts.begin(), ts.end(),
+                                      [&]( auto &t ) { return !useful[ scc[ t.target ] ]; } ), ts.end() );
+            for ( auto &t : ts )
+                if ( scc[ t.target ] != scc[ s ] || marks[ scc[ s ] ].size() != a.nAcceptingSets )
+                    t.accepting.clear();
+        }
+    }
+
+    // sim[ q ][ p ] iff p simulates q
+    Sim simulation()
+    {
+        size_t n = a.states.size();
+        Sim sim( n, std::vector< bool >( n, true ) );
+
+        for ( bool changed = true; changed; )
+        {
+            changed = false;
+            for ( size_t q = 0; q < n; ++q )
+                for ( size_t p = 0; p < n; ++p )
+                    if ( p != q && sim[ q ][ p ] )
+                        for ( auto &t : a.states[ q ] )
+                            if ( std::none_of( a.states[ p ].begin(), a.states[ p ].end(),
+                                               [&]( auto &u ) { return dominates( u, t, sim ); } ) )
+                            {
+                                sim[ q ][ p ] = false;
+                                changed = true;
+                                break;
+                            }
+        }
+
+        return sim;
+    }
+
+    void quotient( const Sim &sim )
+    {
+        size_t n = a.states.size();
+        std::vector< size_t > rep( n );
+        for ( size_t q = 0; q < n; ++q )
+            for ( rep[ q ] = 0; !( sim[ q ][ rep[ q ] ] && sim[ rep[ q ] ][ q ] ); ++ rep[ q ] );
+
+        std::vector< std::vector< Transition > > states( n );
+        for ( size_t q = 0; q < n; ++q )
+            for ( auto t : a.states[ q ] )
+            {
+                t.target = rep[ t.target ];
+                states[ rep[ q ] ].push_back( t );
+            }
+        a.states = states;
+        a.start = rep[ a.start ];
+    }
+
+    void dropDominated( const Sim &sim )
+    {
+        for ( auto &ts : a.states )
+        {
+            std::vector< Transition > keep;
+            for ( size_t i = 0; i < ts.size(); ++i )
+            {
+                bool dominated = false;
+                for ( size_t j = 0; !dominated && j < ts.size(); ++j )
+                    if ( i != j && dominates( ts[ j ], ts[ i ], sim ) )
+                        dominated = j < i || !dominates( ts[ i ], ts[ j ], sim );
+                if ( !dominated )
+                    keep.push_back( ts[ i ] );
+            }
+            ts = keep;
+        }
+    }
+
+    void renumber()
+    {
+        std::vector< size_t > id( a.states.size(), a.states.size() );
+        std::vector< size_t > order{ a.start };
+        id[ a.start ] = 0;
+        for ( size_t i = 0; i < order.size(); ++i )
+            for ( auto &t : a.states[ order[ i ] ] )
+                if ( id[ t.target ] == a.states.size() )
+                {
+                    id[ t.target ] = order.size();
+                    order.push_back( t.target );
+                }
+
+        std::vector< std::vector< Transition > > states;
+        for ( size_t s : order )
+        {
+            states.push_back( a.states[ s ] );
+            for ( auto &t : states.back() )
+                t.target = id[ t.target ];
+        }
+        a.states = states;
+        a.start = 0;
+        a.nStates = states.size();
+    }
+
+    size_t size() const
+    {
+        size_t rv = a.states.size();
+        for ( auto &ts : a.states )
+            rv += ts.size();
+        return rv;
+    }
+
+    void run()
+    {
+        size_t before;
+        do {
+            before = size();
+            prune();
+            renumber();
+            auto sim = simulation();
+            quotient( sim );
+            renumber();
+            dropDominated( simulation() );
+            renumber();
+        } while ( size() < before );
+
+        a.tgba1 = TGBA1( a );
+        a.accSCC.clear();
+        a.computeAccSCC();
+    }
+};
+
+/* The Until labels live in the (shared) formula nodes and the number of
+ * Untils is a global, hence only one translation can run at a time. */
+static inline std::mutex &translation()
+{
+    static std::mutex m;
+    return m;
+}
+
+static inline TGBA2 ltlToTGBA2( LTLPtr formula, bool negate, bool reduce = true )
+{
+    std::lock_guard< std::mutex > _lock( translation() );
+    TGBA2 tgba = ltlToTGBA1( formula, negate );
+    if ( reduce )
+        Reduction( tgba ).run();
+    return tgba;
+}
+
 struct LTL2TGBA /* nodes, states, buchi */
 {
     TEST(node_construction)
@@ -839,6 +1083,38 @@ struct LTL2TGBA /* nodes, states, buchi */
 
     }
 
+    static size_t transitions( const TGBA2 &a )
+    {
+        size_t rv = 0;
+        for ( auto &s : a.states )
+            rv += s.size();
+        return rv;
+    }
+
+    TEST(reduction)
+    {
+        for ( auto f : { "G ( a -> F b )", "F G a || G F b", "( a U b ) U ( c U d )",
+                         "( G F a -> G F b ) && ( G F c -> G F d )" } )
+        {
+            TGBA2 full = ltlToTGBA2( LTL::parse( f ), true, false );
+            TGBA2 reduced = ltlToTGBA2( LTL::parse( f ), true );
+            ASSERT_LEQ( reduced.states.size(), full.states.size() );
+            ASSERT_LEQ( transitions( reduced ), transitions( full ) );
+            ASSERT_EQ( reduced.start, 0 );
+            ASSERT_EQ( reduced.nAcceptingSets, full.nAcceptingSets );
+        }
+
+        TGBA2 fgb = ltlToTGBA2( LTL::parse( "F G a || G F b" ), true );
+        ASSERT_EQ( fgb.states.size(), 2 );
+    }
+
+    TEST(reduction_empty) /* no accepting SCC is left */
+    {
+        TGBA2 a = ltlToTGBA2( LTL::parse( "G a && F ! a" ), false );
+        ASSERT_EQ( a.states.size(), 1 );
+        ASSERT( a.states[ 0 ].empty() );
+    }
+
 };
 
 }
@@ -18,6 +18,7 @@
 #include "ltl.hpp"
 #include <map>
 #include <list>
+#include <unordered_map>
 #include <cassert>
 
 namespace divine {
@@ -25,8 +26,45 @@ namespace ltl {
 
 int LTL::idCounter = 0;
 
-//defines ordering on LTLs
-bool ord( LTLPtr ltlA, LTLPtr ltlB ) // also comparing the sets of Until parents
+std::mutex &LTL::interning()
+{
+    static std::mutex m;
+    return m;
+}
+
+LTLWeak &LTL::interned( const Key &key )
+{
+    struct Hash
+    {
+        size_t operator()( const Key &k ) const
+        {
+            size_t h = std::hash< std::string >()( k.label ) ^ k.op;
+            h = h * 31 + std::hash< LTL * >()( k.left );
+            return h * 31 + std::hash< LTL * >()( k.right );
+        }
+    };
+
+    /* An expired entry may have a dangling key, but then its children are
+     * dead too, and a new node with a recycled address is never a match for
+     * a live formula, so it's enough to sweep the table once in a while. */
+    static std::unordered_map< Key, LTLWeak, Hash > table;
+    static size_t sweep = 1024;
+
+    if ( table.size() > sweep )
+    {
+        for ( auto it = table.begin(); it != table.end(); )
+            if ( it->second.expired() )
+                it = table.erase( it );
+            else
+                ++it;
+        sweep = std::max( sweep, 2 * table.size() );
+    }
+
+    return table[ key ];
+}
+
+//defines ordering on LTLs; formulae are hash-consed, so equal formulae are the same node
+bool ord( LTLPtr ltlA, LTLPtr ltlB )
 {
     if( !ltlA || !ltlB ) {
         if( ltlB ) // if A is nullptr but B is defined.
@@ -34,44 +72,14 @@ bool ord( LTLPtr ltlA, LTLPtr ltlB ) // also comparing the sets of Until parents
         return false;
     }
 
-    if( ltlA->id == ltlB->id )
+    if( ltlA == ltlB )
         return false;
-    if( ltlA->priority() < ltlB->priority() )
-        return true;
-    if( ltlB->priority() < ltlA->priority() )
-        return false;
-    // ltlA and ltlB are the same type and have the same op
-    if( ltlA->is< Boolean >() ) {
-        if( ltlA->get< Boolean >().value == ltlB->get< Boolean >().value )
-            return ltlA->indexesOfUParents() < ltlB->indexesOfUParents();
-        return ltlA->get< Boolean >().value < ltlB->get< Boolean >().value;
-    }
-    else if( ltlA->is< Atom >() ){
-        if( ltlA->string() == ltlB->string() )
-            return ltlA->indexesOfUParents() < ltlB->indexesOfUParents();
-        return ltlA->string() < ltlB->string();
-    }
-    if( ltlA->is< Unary >() ) {
-        if( ord( ltlA->get< Unary >().subExp, ltlB->get< Unary >().subExp ) )
-            return true;
-        if( ord( ltlB->get< Unary >().subExp, ltlA->get< Unary >().subExp ) )
-            return false;
-        return ltlA->indexesOfUParents() < ltlB->indexesOfUParents();
-    }
-    else { // ltlA->is< Binary >() )
-        if( ord( ltlA->get< Binary >().right, ltlB->get< Binary >().right ) )
-            return true;
-        if( ord( ltlB->get< Binary >().right, ltlA->get< Binary >().right ) )
-            return false;
-        if( ord( ltlA->get< Binary >().left, ltlB->get< Binary >().left ) )
-            return true;
-        if( ord( ltlB->get< Binary >().left, ltlA->get< Binary >().left ) )
-            return false;
-        return ltlA->indexesOfUParents() < ltlB->indexesOfUParents();
-    }
+    if( ltlA->priority() != ltlB->priority() )
+        return ltlA->priority() < ltlB->priority();
+    return ltlA->id < ltlB->id;
 }
 
-bool LTLComparator::operator()( LTLPtr ltlA, LTLPtr ltlB ) const // also comparing the sets of Until parents
+bool LTLComparator::operator()( LTLPtr ltlA, LTLPtr ltlB ) const
 {
     return ord( ltlA, ltlB );
 }
@@ -105,9 +113,9 @@ bool ord2( LTLPtr ltlA, LTLPtr ltlB ) // without comparing the sets of Until par
         return true;
     return false;
 }
-bool equal2( LTLPtr ltlA, LTLPtr ltlB ) //without comparing the sets of Until parents
+bool equal2( LTLPtr ltlA, LTLPtr ltlB ) // formulae are hash-consed
 {
-    return !ord2( ltlA, ltlB ) && !ord2( ltlB, ltlA );
+    return ltlA == ltlB;
 }
 
 bool LTLComparator2::operator()( LTLPtr ltlA, LTLPtr ltlB ) const // without comparing the sets of Until parents
@@ -177,7 +185,7 @@ int Binary::countAndLabelU( int seed  /* = 0 */ )
     return r + 1;
 }
 
-LTLPtr Boolean::normalForm() { return LTL::make( value ); } // returns shared pointer to a NEW COPY of the Bool
+LTLPtr Boolean::normalForm() { return LTL::make( value ); } // the same (hash-consed) node
 
 LTLPtr Boolean::normalForm( bool neg )
 {
@@ -186,7 +194,7 @@ LTLPtr Boolean::normalForm( bool neg )
     return normalForm();
 }
 
-LTLPtr Atom::normalForm() { return LTL::make( label ); } // returns shared pointer to a NEW COPY of the Atom
+LTLPtr Atom::normalForm() { return LTL::make( label ); } // the same (hash-consed) node
 
 LTLPtr Atom::normalForm( bool neg )
 {
@@ -709,12 +717,138 @@ LTLPtr LTL::parse( const std::string& str, bool typeRERS /*= false*/ )
 
 LTLPtr LTL::Simplifier::makeSimpler( LTLPtr form )
 {
+    auto it = done.find( form );
+    if( it != done.end() )
+        return it->second;
+    auto simpler = simplify( form );
+    done.emplace( form, simpler );
+    return simpler;
+}
+
+static bool isBool( LTLPtr form, bool value )
+{
+    return form->is< Boolean >() && form->get< Boolean >().value == value;
+}
+
+static LTLPtr subOf( LTLPtr form ) { return form->get< Unary >().subExp; }
+static LTLPtr leftOf( LTLPtr form ) { return form->get< Binary >().left; }
+static LTLPtr rightOf( LTLPtr form ) { return form->get< Binary >().right; }
+
+// is the formula of the form op1 op2 _ (e.g. G F _)?
+static bool isType2( LTLPtr form, Unary::Operator op1, Unary::Operator op2 )
+{
+    return form->isType( op1 ) && subOf( form )->isType( op2 );
+}
+
+// rewrites of binary formulae (equivalences, each making the formula smaller), nullptr if none applies
+static LTLPtr simplifyBinary( Binary::Operator op, LTLPtr left, LTLPtr right )
+{
+    auto neg = []( LTLPtr f ) { return LTL::make( Unary::Neg, f ); };
+
+    switch( op )
+    {
+        case Binary::Until:
+            if( left == right || isBool( left, false ) )                    // a U a = a, false U b = b
+                return right;
+            if( right->isType( Binary::Until ) && leftOf( right ) == left ) // a U ( a U b ) = a U b
+                return right;
+            if( left->isType( Binary::Until ) && rightOf( left ) == right ) // ( a U b ) U b = a U b
+                return left;
+            break;
+        case Binary::Release:
+            if( left == right || isBool( left, true ) || right->is< Boolean >() ) // a R a = a, true R b = b,
+                return right;                                                   // a R true = true, a R false = false
+            if( right->isType( Binary::Release ) && leftOf( right ) == left )     // a R ( a R b ) = a R b
+                return right;
+            break;
+        case Binary::WeakUntil:
+            if( left == right || isBool( right, true ) || isBool( left, false ) ) // a W a = a, a W true = true,
+                return right;                                                   // false W b = b
+            if( isBool( left, true ) )                                          // true W b = true
+                return left;
+            if( isBool( right, false ) )                                        // a W false = G a
+                return LTL::make( Unary::Global, left );
+            break;
+        case Binary::Impl:
+            if( left == right || isBool( left, false ) || isBool( right, true ) ) // a -> a = true, false -> b = true,
+                return LTL::make( true );                                       // a -> true = true
+            if( isBool( left, true ) )                                          // true -> b = b
+                return right;
+            if( isBool( right, false ) )                                        // a -> false = !a
+                return neg( left );
+            break;
+        case Binary::Equiv:
+            if( left == right )                                                 // a <-> a = true
+                return LTL::make( true );
+            if( left->is< Boolean >() )                                         // true <-> b = b, false <-> b = !b
+                return left->get< Boolean >().value ? right : neg( right );
+            if( right->is< Boolean >() )
+                return right->get< Boolean >().value ? left : neg( left );
+            break;
+        case Binary::And:
+            if( right->isType( Binary::Or ) && ( leftOf( right ) == left || rightOf( right ) == left ) )
+                return left;                                                    // a && ( a || b ) = a
+            if( left->isType( Binary::Or ) && ( leftOf( left ) == right || rightOf( left ) == right ) )
+                return right;                                                   // ( a || b ) && a = a
+            if( left->isType( Unary::Global ) && right->isType( Unary::Global ) ) // G a && G b = G ( a && b )
+                return LTL::make( Unary::Global, LTL::make( Binary::And, subOf( left ), subOf( right ) ) );
+            if( left->isType( Unary::Next ) && right->isType( Unary::Next ) )     // X a && X b = X ( a && b )
+                return LTL::make( Unary::Next, LTL::make( Binary::And, subOf( left ), subOf( right ) ) );
+            if( isType2( left, Unary::Future, Unary::Global ) && isType2( right, Unary::Future, Unary::Global ) )
+                return LTL::make( Unary::Future, LTL::make( Unary::Global,      // F G a && F G b = F G ( a && b )
+                            LTL::make( Binary::And, subOf( subOf( left ) ), subOf( subOf( right ) ) ) ) );
+            break;
+        case Binary::Or:
+            if( right->isType( Binary::And ) && ( leftOf( right ) == left || rightOf( right ) == left ) )
+                return left;                                                    // a || ( a && b ) = a
+            if( left->isType( Binary::And ) && ( leftOf( left ) == right || rightOf( left ) == right ) )
+                return right;                                                   // ( a && b ) || a = a
+            if( left->isType( Unary::Future ) && right->isType( Unary::Future ) ) // F a || F b = F ( a || b )
+                return LTL::make( Unary::Future, LTL::make( Binary::Or, subOf( left ), subOf( right ) ) );
+            if( left->isType( Unary::Next ) && right->isType( Unary::Next ) )     // X a || X b = X ( a || b )
+                return LTL::make( Unary::Next, LTL::make( Binary::Or, subOf( left ), subOf( right ) ) );
+            break;
+    }
+    return nullptr;
+}
+
+LTLPtr LTL::Simplifier::simplify( LTLPtr form )
+{
+    if( form->isType( Unary::Neg ) )
+    {
+        auto subExp = subOf( form );
+        if( subExp->is< Boolean >() )                                       // !true = false, !false = true
+        {
+            changed = true;
+            return LTL::make( !subExp->get< Boolean >().value );
+        }
+        if( subExp->isType( Unary::Neg ) )                                  // !!a = a
+        {
+            changed = true;
+            return makeSimpler( subOf( subExp ) );
+        }
+    }
     if( form->isAtomOrBooleanOrNeg() )                                      // a, !a, True, False
         return form;
     if( form->is< Unary >() )
     {
         auto op = form->get< Unary >().op;
         auto subExp = form->get< Unary >().subExp;
+        if( op != Unary::Neg && subExp->is< Boolean >() )                   // X true = G true = F true = true, also false
+        {
+            changed = true;
+            return subExp;
+        }
+        if( op == Unary::Future && subExp->isType( Unary::Future ) )         // F F x = F x
+        {
+            changed = true;
+            return makeSimpler( subExp );
+        }
+        if( op == Unary::Global && isType2( subExp, Unary::Future, Unary::Global ) ) // G F G x = F G x
+        {
+            changed = true;
+            return makeSimpler( subExp );
+        }
         if( op == Unary::Global )                                                    // G _
         {
             // G G x = G x
@@ -797,6 +931,11 @@ LTLPtr LTL::Simplifier::makeSimpler( LTLPtr form )
         auto op = form->get< Binary >().op;
         auto right = form->get< Binary >().right;
         auto left = form->get< Binary >().left;
+        if( auto simpler = simplifyBinary( op, left, right ) )
+        {
+            changed = true;
+            return makeSimpler( simpler );
+        }
         if( op == Binary::Until )                               // p U false = false   \/   p U true = true
         {
             if( right->is<Boolean>() )
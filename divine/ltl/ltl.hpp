@@ -17,7 +17,10 @@
 
 #include <sstream>
 #include <brick-types>
+#include <algorithm>
 #include <cassert>
+#include <map>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -34,7 +37,7 @@ using LTLWeak = std::weak_ptr< LTL >;
 
 struct LTLComparator
 {
-    // @return true iff ltlA < ltlB lexicographically on strings or if equal strings but smaller U parents
+    // @return true iff ltlA < ltlB by priority, formulae of the same priority are ordered by their id
     bool operator()( LTLPtr ltlA, LTLPtr ltlB ) const;
 };
 
@@ -168,8 +171,14 @@ struct LTL : Exp, std::enable_shared_from_this< LTL >
         assert( isComplete() );
         if( is< Binary >() )
         {
-            if( isType( Binary::Until ) )
-                get< Binary >().right->UParents.push_back( shared_from_this() );
+            if( isType( Binary::Until ) ) // subformulae may be shared, add each parent once
+            {
+                auto &parents = get< Binary >().right->UParents;
+                auto self = shared_from_this();
+                if( std::none_of( parents.begin(), parents.end(),
+                                  [&]( LTLWeak p ) { return p.lock() == self; } ) )
+                    parents.push_back( self );
+            }
             get< Binary >().right->computeUParents();
             get< Binary >().left->computeUParents();
         }
@@ -222,15 +231,57 @@ struct LTL : Exp, std::enable_shared_from_this< LTL >
         return apply( [=]( auto e ) -> LTLPtr { return e.normalForm( neg ); } ).value();
     }
 
+    /* Complete formulae are hash-consed: make returns the existing node when
+     * the same formula is already alive, so that structurally equal formulae
+     * are also equal as pointers. Incomplete nodes (the operator tokens of
+     * the parser) are always fresh. Formulae may be built by more than one
+     * thread at a time, hence the table (and the id counter) are guarded by
+     * a lock. */
+    struct Key
+    {
+        int op;            /* kind and operator (or value for Boolean) */
+        std::string label; /* for Atom */
+        LTL *left, *right;
+        bool operator==( const Key &o ) const
+        {
+            return op == o.op && left == o.left && right == o.right && label == o.label;
+        }
+    };
+
+    static std::mutex &interning();
+    static LTLWeak &interned( const Key &key );
+
+    template< typename T >
+    static LTLPtr intern( T t, Key key )
+    {
+        std::lock_guard< std::mutex > _lock( interning() );
+
+        auto fresh = [&]
+        {
+            LTLPtr newForm = std::make_shared< LTL >( t );
+            newForm->id = ++idCounter;
+            return newForm;
+        };
+
+        if ( !t.isComplete() )
+            return fresh();
+
+        auto &slot = interned( key );
+        if ( auto existing = slot.lock() )
+            return existing;
+
+        auto newForm = fresh();
+        slot = newForm;
+        return newForm;
+    }
+
     static LTLPtr make( Binary::Operator op, LTLPtr left = nullptr, LTLPtr right = nullptr )
     {
         Binary binary;
         binary.op = op;
         binary.left = left;
         binary.right = right;
-        LTLPtr newForm = std::make_shared< LTL >( binary );
-        newForm->id = ++idCounter;
-        return newForm;
+        return intern( binary, Key{ 48 + op, "", left.get(), right.get() } );
     }
 
     static LTLPtr make( Unary::Operator op, LTLPtr subExp = nullptr )
@@ -238,9 +289,7 @@ struct LTL : Exp, std::enable_shared_from_this< LTL >
         Unary unary;
         unary.op = op;
         unary.subExp = subExp;
-        LTLPtr newForm = std::make_shared< LTL >( unary );
-        newForm->id = ++idCounter;
-        return newForm;
+        return intern( unary, Key{ 32 + op, "", subExp.get(), nullptr } );
     }
 
     static LTLPtr make( const char* label )
@@ -256,18 +305,30 @@ struct LTL : Exp, std::enable_shared_from_this< LTL >
             return make( false );
         Atom atom;
         atom.label = label;
-        LTLPtr newForm = std::make_shared< LTL >( atom );
-        newForm->id = ++idCounter;
-        return newForm;
+        return intern( atom, Key{ 16, label, nullptr, nullptr } );
     }
 
     static LTLPtr make( bool value )
     {
         Boolean boolean;
         boolean.value = value;
-        LTLPtr newForm = std::make_shared< LTL >( boolean );
-        newForm->id = ++idCounter;
-        return newForm;
+        return intern( boolean, Key{ value, "", nullptr, nullptr } );
+    }
+
+    /* forget the Until labels (see countAndLabelU and computeUParents) of
+     * this formula and all its subformulae, which may be left over from an
+     * earlier translation of a formula which shares them */
+    void clearLabels()
+    {
+        UParents.clear();
+        if( is< Binary >() )
+        {
+            get< Binary >().untilIndex = -1;
+            get< Binary >().left->clearLabels();
+            get< Binary >().right->clearLabels();
+        }
+        else if( is< Unary >() )
+            get< Unary >().subExp->clearLabels();
     }
 
     struct Simplifier{
@@ -275,7 +336,19 @@ struct LTL : Exp, std::enable_shared_from_this< LTL >
         Simplifier( bool _changed )
             : changed( _changed )
         {}
+        std::map< LTLPtr, LTLPtr > done; // subformulae simplified in this pass
         LTLPtr makeSimpler( LTLPtr form );
+        LTLPtr simplify( LTLPtr form );
+
+        static LTLPtr simplest( LTLPtr form ) // simplify until nothing changes
+        {
+            for ( Simplifier s( true ); s.changed; )
+            {
+                s = Simplifier( false );
+                form = s.makeSimpler( form );
+            }
+            return form;
+        }
     };
 };
 
@@ -550,6 +623,54 @@ struct LTLNF /* normal forms */
     }
 };
 
+struct hashConsing
+{
+    TEST(pointer_equality)
+    {
+        auto f = LTL::parse( "G ( a -> F b )" );
+        ASSERT( f == LTL::parse( "G(a -> F b)" ) );
+        ASSERT( f != LTL::parse( "G ( b -> F a )" ) );
+        ASSERT( LTL::make( "a" ) == f->get< Unary >().subExp->get< Binary >().left );
+        ASSERT( LTL::make( Binary::Until, LTL::make( "a" ), LTL::make( "b" ) ) == LTL::parse( "a U b" ) );
+    }
+
+    TEST(incomplete)
+    {
+        ASSERT( LTL::make( Binary::And ) != LTL::make( Binary::And ) );
+    }
+};
+
+struct simplifier
+{
+    static void simpler( std::string f, std::string exp )
+    {
+        ASSERT_EQ( LTL::Simplifier::simplest( LTL::parse( f ) )->string(), exp );
+    }
+
+    TEST(booleans)
+    {
+        simpler( "! ! a", "a" );
+        simpler( "X true && a", "a" );
+        simpler( "a -> false", "!a" );
+        simpler( "true <-> ( a U b )", "( a U b )" );
+        simpler( "G ( a -> a )", "true" );
+        simpler( "a && ( a || b )", "a" );
+    }
+
+    TEST(temporal)
+    {
+        simpler( "F F a", "Fa" );
+        simpler( "G F G a", "FGa" );
+        simpler( "a U ( a U b )", "( a U b )" );
+        simpler( "( a U b ) U b", "( a U b )" );
+        simpler( "a R ( a R b )", "( a R b )" );
+        simpler( "a W false", "Ga" );
+        simpler( "G a && G b", "G( a & b )" );
+        simpler( "F a || F b", "F( a | b )" );
+        simpler( "X a || X b", "X( a | b )" );
+    }
+};
+
 struct typeDetection
 {
     TEST(test_isType)
@@ -17,6 +17,7 @@
  */
 
 #include <divine/rt/dios-cc.hpp>
+#include <divine/rt/prune.hpp>
 #include <divine/mc/bitcode.hpp>
 #include <divine/vm/memory.tpp>
 #include <divine/vm/program.hpp>
@@ -32,10 +33,16 @@ DIVINE_RELAX_WARNINGS
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/DiagnosticPrinter.h>
 #include <llvm/Object/IRObjectFile.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/raw_ostream.h>
 DIVINE_UNRELAX_WARNINGS
 
 #include <brick-llvm>
+#include <brick-sha2>
+#include <brick-fs>
 
+#include <set>
+#include <sstream>
 #include <utility>
 
 namespace divine::mc
@@ -111,13 +118,23 @@ brq::parse_result from_string( std::string_view x, autotrace &fl )
 void BitCode::lazy_link_dios()
 {
     bool has_boot = _module->getFunction( "__boot" );
+    std::set< std::string > defined;
+
+    for ( auto &gv : _module->global_values() )
+        if ( !gv.isDeclaration() )
+            defined.insert( gv.getName().str() );
 
     rt::DiosCC drv( _ctx );
     drv.link( std::move( _module ) );
 
     if ( !has_boot )
-        drv.link_dios_config( _opts.dios_config, _opts.lamp_config );
+        drv.link_dios_config( _opts.dios_config, _opts.lamp_config, _runtime_cache );
     _module = drv.takeLinked();
+
+    /* custom LART passes and the McSema lowering may look up any runtime
+     * function by name, hence the runtime is only pruned without them */
+    if ( !has_boot && _opts.lart_passes.empty() && !_opts.mcsema )
+        rt::prune( *_module, defined );
 }
 
 void BitCode::_save_original_module()
@@ -125,10 +142,8 @@ void BitCode::_save_original_module()
     _pure_module = llvm::CloneModule( *_module );
 }
 
-BitCode::BitCode( std::string file )
+static std::unique_ptr< llvm::Module > load_module( std::string file, llvm::LLVMContext &ctx )
 {
-    _ctx.reset( new llvm::LLVMContext() );
-
     using namespace llvm::object;
 
     llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr = llvm::MemoryBuffer::getFile(file);
@@ -139,10 +154,27 @@ BitCode::BitCode( std::string file )
 
     if ( !bc )
         throw BCParseError(toString( bc.takeError() ) );
-    auto parsed = llvm::parseBitcodeFile( bc.get(), *_ctx );
+    auto parsed = llvm::parseBitcodeFile( bc.get(), ctx );
     if ( !parsed )
         throw BCParseError( "Error parsing input model; probably not a valid bitcode file." );
-    _module = std::move( parsed.get() );
+    return std::move( parsed.get() );
+}
+
+/* unlike brick::llvm::writeModule, this does not verify the module, since the
+ * output of LART is not (yet) guaranteed to pass the verifier */
+static void write_module( llvm::Module *m, std::string file )
+{
+    std::error_code err;
+    llvm::raw_fd_ostream out( file, err, llvm::sys::fs::OF_None );
+    if ( err )
+        brq::raise() << "could not write " << file << ": " << err.message();
+    llvm::WriteBitcodeToFile( *m, out );
+}
+
+BitCode::BitCode( std::string file )
+{
+    _ctx.reset( new llvm::LLVMContext() );
+    _module = load_module( file, *_ctx );
 }
 
 
@@ -156,6 +188,9 @@ BitCode::BitCode( std::unique_ptr< llvm::Module > m, std::shared_ptr< llvm::LLVM
 
 void BitCode::do_lart()
 {
+    if ( _cached )
+        return;
+
     _save_original_module();
 
     // TODO: Unify with lart::Driver once it is rewritten
@@ -226,6 +261,9 @@ void BitCode::do_lart()
     lart.process( mod );
 
     // TODO brick::llvm::verifyModule( mod );
+
+    if ( !_cache_path.empty() )
+        _store_cache();
 }
 
 void BitCode::do_rr()
@@ -244,7 +282,79 @@ void BitCode::do_constants()
 
 void BitCode::do_dios()
 {
-    lazy_link_dios();
+    if ( !_cached )
+        lazy_link_dios();
+}
+
+/* Besides the build, the prepared module depends on the input module and on
+ * the options which are used by do_dios() and do_lart(). */
+std::string BitCode::cache_key( std::string build )
+{
+    std::stringstream key;
+    auto str = [&]( std::string_view s ) { key << s.size() << ":" << s << ";"; };
+
+    str( build );
+    str( brick::llvm::getModuleBytes( _module.get() ) );
+
+    key << _opts.bc_env.size() << ";";
+    for ( auto &[ name, value ] : _opts.bc_env )
+        str( name ), str( std::string_view( reinterpret_cast< const char * >( value.data() ),
+                                            value.size() ) );
+
+    key << _opts.lart_passes.size() << ";";
+    for ( auto &pass : _opts.lart_passes )
+        str( pass );
+
+    str( _opts.dios_config ), str( _opts.lamp_config ), str( _opts.relaxed );
+    str( to_string( _opts.autotrace ) ), str( to_string( _opts.leakcheck ) );
+    key << bool( _opts.static_reduction ) << bool( _opts.symbolic ) << bool( _opts.sequential )
+        << bool( _opts.synchronous ) << bool( _opts.svcomp ) << bool( _opts.mcsema );
+
+    return brq::to_hex( brq::sha2_256( key.str() ) );
+}
+
+void BitCode::use_cache( std::string dir, std::string build )
+{
+    ASSERT( !_cached );
+    brq::create_dir( dir );
+    _cache_path = brq::join_path( std::vector< std::string_view >{ dir, cache_key( build ) } );
+
+    auto runtime = build + ";" + _opts.dios_config + ";" + _opts.lamp_config;
+    _runtime_cache = brq::join_path( std::vector< std::string_view >{
+            dir, "dios-" + brq::to_hex( brq::sha2_256( runtime ) ) + ".bc" } );
+
+    /* the -pure file is written first, see _store_cache() */
+    if ( !brq::file_exists( _cache_path + ".bc" ) )
+        return;
+
+    if ( !_ctx )
+        _ctx.reset( new llvm::LLVMContext() );
+
+    try
+    {
+        auto pure = load_module( _cache_path + "-pure.bc", *_ctx );
+        _module = load_module( _cache_path + ".bc", *_ctx );
+        _pure_module = std::move( pure );
+        _cached = true;
+    }
+    catch ( BCParseError & ) {} /* a damaged entry is rebuilt and replaced */
+}
+
+/* Concurrent runs (possibly in the same process, see `divine serve`) may be
+ * preparing the same program: each writes into its own temporary files and
+ * then renames them into place, which is atomic. */
+void BitCode::_store_cache()
+{
+    auto tmp = brq::temp_name( _cache_path );
+
+    try
+    {
+        write_module( _pure_module.get(), tmp + "-pure.bc" );
+        write_module( _module.get(), tmp + ".bc" );
+        brq::rename_if_exists( tmp + "-pure.bc", _cache_path + "-pure.bc" );
+        brq::rename_if_exists( tmp + ".bc", _cache_path + ".bc" );
+    }
+    catch ( std::exception & ) {} /* failing to fill the cache is not fatal */
 }
 
 void BitCode::init()
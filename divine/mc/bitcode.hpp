@@ -38,6 +38,8 @@ namespace divine::vm { struct Program; }
 
 namespace divine::mc
 {
+    struct Automaton;
+
     enum class autotrace { nothing, calls = 1, allocs = 2 };
     enum class leakcheck { nothing, exit = 0x1 , ret = 0x2 , state = 0x4 };
 
@@ -92,11 +94,19 @@ struct BitCode
     std::unique_ptr< llvm::Module > _pure_module; // pre-LART version
     std::unique_ptr< dbg::Info > _dbg;
 
+    std::string _cache_path; /* prefix of the cache entry, see use_cache() */
+    std::string _runtime_cache; /* the prelinked DiOS, see DiosCC::link_dios_config */
+    bool _cached = false;
+
     std::string _solver;
+    bool _subsumption = false;
+    std::shared_ptr< Automaton > _automaton;
     BCOptions _opts;
 
     bool is_symbolic() const { return _opts.symbolic; }
     std::string solver() const { ASSERT( is_symbolic() ); return _solver; }
+    bool subsumption() const { return _subsumption; }
+    Automaton *automaton() const { return _automaton.get(); }
 
     vm::Program &program() { ASSERT( _program.get() ); return *_program.get(); }
     dbg::Info &debug() { ASSERT( _dbg.get() ); return *_dbg.get(); }
@@ -107,12 +117,26 @@ struct BitCode
 
     void set_options( const BCOptions& opts ) { _opts = opts; }
     void solver( std::string s ) { _solver = s; }
+    void subsumption( bool s ) { _subsumption = s; }
+    void automaton( std::shared_ptr< Automaton > a ) { _automaton = a; }
 
     void do_lart();
     void do_dios();
     void do_rr();
     void do_constants();
 
+    /* Look up the prepared module (i.e. the one linked with DiOS and processed
+     * by LART) in an on-disk cache, keyed on the input module, the options
+     * and the given build identifier. On a hit, do_dios() and do_lart() do
+     * nothing, otherwise do_lart() stores its result in the cache. The
+     * prelinked DiOS runtime used by do_dios() is kept in the same directory.
+     * Must be called before do_dios(). The vm::Program is not cached, since
+     * dbg::Info (and hence counterexamples and LTL propositions) needs the
+     * mapping from LLVM values to addresses which do_rr() computes: do_rr()
+     * and do_constants() run on every load, cached or not. */
+    void use_cache( std::string dir, std::string build );
+    std::string cache_key( std::string build );
+
     void init();
 
     // TODO: Disables move synthesis, probably should be removed
@@ -123,6 +147,7 @@ struct BitCode
 private:
     void lazy_link_dios();
     void _save_original_module();
+    void _store_cache();
 };
 
 }
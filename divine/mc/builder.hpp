@@ -22,6 +22,7 @@
 #include <divine/mc/bitcode.hpp>
 #include <divine/mc/hasher.hpp>
 #include <divine/mc/context.hpp>
+#include <divine/mc/product.hpp>
 #include <divine/smt/solver.hpp>
 #include <divine/vm/value.hpp>
 #include <divine/vm/memory.tpp>
@@ -69,12 +70,13 @@ struct Builder
         std::vector< std::string > trace;
         std::vector< vm::Choice > stack;
         std::vector< vm::Interrupt > interrupts;
+        uint64_t marks = 0; /* acceptance marks of the property automaton */
         bool accepting:1;
         bool error:1;
         auto as_tuple() const
         {
             /* skip the text trace for comparison purposes */
-            return std::make_tuple( stack, interrupts, accepting, error );
+            return std::make_tuple( stack, interrupts, marks, accepting, error );
         }
     };
 
@@ -91,12 +93,17 @@ struct Builder
         Context ctx;
         HT states;
         builder::State initial;
+        vm::HeapPointer globals; /* of the initial process, for reading propositions */
         Solver solver;
         vm::CowHeap::Pool pool;
 
         int64_t local_instructions = 0, local_states = 0;
         std::shared_ptr< std::atomic< int64_t > > total_instructions, total_states;
 
+        /* a capacity requested for the state table, picked up (and reset to
+         * zero) by whichever thread stores a state next, see reserve() */
+        std::shared_ptr< std::atomic< int64_t > > reserve;
+
         template< typename... Args >
         Data( BC bc, Args... solver_opts )
             : Data( bc, Context( bc->program() ), HT(), solver_opts... )
@@ -106,7 +113,8 @@ struct Builder
         Data( BC bc, const Context &ctx, HT states, Args... solver_opts )
             : bc( bc ), ctx( ctx ), states( states ), solver( solver_opts... ),
               total_instructions( new std::atomic< int64_t >( 0 ) ),
-              total_states( new std::atomic< int64_t >( 0 ) )
+              total_states( new std::atomic< int64_t >( 0 ) ),
+              reserve( new std::atomic< int64_t >( 0 ) )
         {}
 
         void sync()
@@ -119,22 +127,81 @@ struct Builder
         ~Data() { sync(); }
     } _d;
     Hasher _hasher;
+    std::vector< vm::GenericPointer > _props;
 
     Context &context() { return _d.ctx; }
+    Automaton *automaton() { return _d.bc->automaton(); }
     void enable_overwrite() { _hasher.overwrite = true; }
 
     auto &hasher() { return _hasher; }
 
-    Builder( const Builder &e ) : _d( e._d ), _hasher( e._hasher, _d.pool, _d.solver )
+    Builder( const Builder &e )
+        : _d( e._d ), _hasher( e._hasher, _d.pool, _d.solver ), _props( e._props )
     {}
 
     template< typename... Args >
     Builder( BC bc, Args && ... args ) : _d( bc, args... ), _hasher( _d.pool, _d.ctx.heap(), _d.solver )
-    {}
+    {
+        _hasher.subsumption = bc->subsumption();
+
+        if ( auto a = automaton() )
+        {
+            _hasher.enable_tags();
+            for ( auto name : a->props() )
+                if ( auto var = debug().global( name ) )
+                    _props.push_back( program().addr( var ) );
+                else
+                    brq::raise() << "the atomic proposition " << name
+                                 << " does not name a global variable";
+        }
+    }
+
+    /* bit i is set iff the i-th atomic proposition holds in the loaded state */
+    uint64_t valuation()
+    {
+        uint64_t v = 0;
+
+        for ( size_t i = 0; i < _props.size(); ++i )
+        {
+            auto slot = program()._globals[ _props[ i ].object() ];
+            auto ptr = _d.globals + slot.offset;
+            int size = slot.size();
+
+            for ( int off = 0; off < size; ++off )
+            {
+                vm::value::Int< 8 > byte;
+                heap().read( ptr + off, byte );
+                if ( byte.cooked() )
+                {
+                    v |= 1ull << i;
+                    break;
+                }
+            }
+        }
+
+        return v;
+    }
+
+    /* a fresh copy of a snapshot, so that it can carry a different tag */
+    Snapshot copy( Snapshot snap )
+    {
+        heap().restore( pool(), snap );
+        return heap().snapshot( pool() );
+    }
+
+    /* ask the state table to grow to (at least) the given capacity; the
+     * table can only be resized by a thread with a hasher, so this is done
+     * lazily by the next call to store() in any of the workers */
+    void reserve( int64_t cells ) { *_d.reserve = cells; }
 
     std::pair< Snapshot, bool > store( Snapshot snap )
     {
         hash_timer _timer;
+
+        if ( int64_t cells = _d.reserve->load( std::memory_order_relaxed ) )
+            if ( _d.reserve->compare_exchange_strong( cells, 0 ) )
+                _d.states.reserve( cells, hasher() );
+
         _hasher.prepare( snap );
         auto r = _d.states.insert( snap, hasher() );
         if ( r->load() != snap )
@@ -155,12 +222,15 @@ struct Builder
     {
         Eval eval( context() );
         vm::setup::boot( context() );
+        _d.globals = context().globals();
         context().track_memory( false );
         eval.run();
         hasher()._root = context().state_ptr();
         hasher()._path = context().constraint_ptr();
 
         auto s = context().snapshot( pool() );
+        if ( automaton() )
+            hasher().tag( s, automaton()->initial() );
         if ( vm::setup::postboot_check( context() ) )
             std::tie( _d.initial.snap, std::ignore ) = store( s );
         _d.sync();
@@ -172,12 +242,15 @@ struct Builder
     Snapshot start( const Ctx &ctx, Snapshot snap )
     {
         context().load( ctx ); /* copy over registers */
+        _d.globals = context().globals();
         context().track_memory( false );
         hasher()._h1 = ctx.heap();
         hasher()._h2 = ctx.heap();
         hasher()._root = context().state_ptr();
         hasher()._path = context().constraint_ptr();
 
+        if ( automaton() )
+            hasher().tag( snap, automaton()->initial() );
         if ( context().heap().valid( hasher()._root ) )
             std::tie( _d.initial.snap, std::ignore ) = store( snap );
         _d.sync();
@@ -226,28 +299,77 @@ struct Builder
             Label lbl;
             Snapshot snap;
             bool feasible:1;
+            int batch_id = -1;
             vm::GenericPointer tid;
             Check() : feasible( true ) {}
         };
 
         std::vector< Check > to_check;
+        smt::solver::Batch batch;
+
+        /* the final feasibility check of a successor can wait until all of
+         * them have been generated, and then be solved as a single batch */
+        auto enqueue = [&]( Check &tc )
+        {
+            if ( context().flags_any( _VM_CF_Cancel ) )
+                return false;
+            tc.batch_id = batch.owner();
+            for ( auto a : context()._assume )
+                if ( context().heap().valid( a ) )
+                    _d.solver.enqueue( batch, tc.batch_id, context().heap(), a );
+            return bool( batch.result[ tc.batch_id ] );
+        };
+
+        /* the moves of the property automaton, which are taken in lockstep
+         * with each transition of the program; with k moves, each program
+         * successor gives rise to k successors in the product */
+        std::vector< std::pair< Automaton::Tag, uint64_t > > moves;
+
+        if ( auto a = automaton() )
+        {
+            context().load( pool(), from.snap );
+            a->step( hasher().tag( from.snap ), valuation(),
+                     [&]( auto tag, auto marks ) { moves.emplace_back( tag, marks ); } );
+            std::sort( moves.begin(), moves.end() );
+            moves.erase( std::unique( moves.begin(), moves.end() ), moves.end() );
+            if ( moves.empty() )
+                return; /* the automaton is stuck, the run is not accepted */
+        }
 
         auto do_yield = [&]( Snapshot snap, Label lbl )
         {
             builder::State st;
             bool isnew;
 
-            std::tie( st.snap, isnew ) = store( snap );
-            yield( st, lbl, isnew );
+            if ( moves.empty() )
+            {
+                std::tie( st.snap, isnew ) = store( snap );
+                yield( st, lbl, isnew );
+                return;
+            }
+
+            for ( size_t i = 0; i < moves.size(); ++i )
+            {
+                auto s = i + 1 < moves.size() ? copy( snap ) : snap;
+                auto l = lbl;
+                hasher().tag( s, moves[ i ].first );
+                l.marks = moves[ i ].second;
+                /* only used to mark the interesting part of a trace */
+                l.accepting = lbl.accepting || l.marks || !automaton()->sets();
+                std::tie( st.snap, isnew ) = store( s );
+                yield( st, l, isnew );
+            }
         };
 
-        auto do_eval = [&]( Check &tc )
+        auto do_eval = [&]( Check &tc, bool defer )
         {
             divm_timer _timer;
             bool cont = false;
             do {
                 cont = eval.run_seq( cont );
-                tc.feasible = feasible();
+                /* when a choice follows, check right away, so that we do not
+                 * branch out from an infeasible path */
+                tc.feasible = cont || !defer ? feasible() : enqueue( tc );
             } while ( cont && tc.feasible );
         };
 
@@ -263,7 +385,7 @@ struct Builder
             to_check.emplace_back();
             auto &tc = to_check.back();
 
-            do_eval( tc );
+            do_eval( tc, true );
             _d.local_instructions += context().instruction_count();
 
             for ( int i = 0; i < context()._level; ++i )
@@ -278,6 +400,14 @@ struct Builder
         } while ( !context().finished() );
 
         context().track_memory( false );
+        _d.solver.solve( batch );
+
+        for ( auto &tc : to_check )
+            if ( tc.feasible && tc.batch_id >= 0 && !batch.result[ tc.batch_id ] )
+            {
+                tc.feasible = false;
+                context().heap().snap_put( pool(), tc.snap );
+            }
 
         for ( auto &tc : to_check )
         {
@@ -319,7 +449,7 @@ struct Builder
                 context()._crit_stores = s;
                 vm::setup::scheduler( context() );
 
-                do_eval( tc );
+                do_eval( tc, false );
                 ASSERT_EQ( tc.tid, context()._tid );
                 _d.local_instructions += context().instruction_count();
 
@@ -340,6 +470,37 @@ struct Builder
         }
     }
 
+    /* Re-execute a single transition out of a given state, as recorded in
+     * 'step' (the choices and interrupts from its label), and return the label
+     * of the transition. No successor is stored, and feasibility is not
+     * checked: the step is assumed to be taken from an earlier exploration. */
+    Label replay( Snapshot from, const vm::Step &step )
+    {
+        Eval eval( context() );
+        ASSERT( context()._stack.empty() );
+        ASSERT( context()._lock.empty() );
+
+        context().load( pool(), from );
+        context()._lock = step.choices;
+        context()._replay = step.interrupts;
+        vm::setup::scheduler( context() );
+
+        bool cont = false;
+        do
+            cont = eval.run_seq( cont );
+        while ( cont );
+
+        auto lbl = label();
+        ASSERT( context()._lock.empty() );
+        ASSERT( context()._replay->empty() );
+
+        context()._stack.clear();
+        context()._lock.clear();
+        context()._replay.reset();
+        context().finished();
+        return lbl;
+    }
+
     template< typename Y >
     void initials( Y yield )
     {
@@ -18,6 +18,7 @@
 
 #pragma once
 #include <divine/smt/extract.hpp>
+#include <optional>
 
 namespace divine::mc
 {
@@ -33,6 +34,7 @@ namespace divine::mc
         std::string _info;
         std::vector< vm::Choice > _stack;
         std::deque< vm::Choice > _lock;
+        std::optional< std::deque< vm::Interrupt > > _replay;
         std::vector< vm::HeapPointer > _assume;
         vm::GenericPointer _tid;
         MemMap _mem_loads, _mem_stores, _crit_loads, _crit_stores;
@@ -89,10 +91,33 @@ namespace divine::mc
                 trace( "ASSUME " + smt::extract::to_string( heap(), ta.ptr ) );
         }
 
+        /* when re-executing a recorded transition, interrupts happen exactly
+         * where they were recorded, regardless of the loop counters and the
+         * critical memory maps */
+        bool replay_test( vm::Interrupt::Type t, vm::CodePointer pc )
+        {
+            auto &next = *_replay;
+            if ( next.empty() || next.front().ictr != this->instruction_count() )
+                return false;
+            ASSERT_EQ( t, next.front().type );
+            ASSERT_EQ( pc, next.front().pc );
+            next.pop_front();
+            return track_test( t, pc );
+        }
+
+        bool test_loop( vm::CodePointer pc, int ctr )
+        {
+            if ( _replay && !this->flags_all( _VM_CF_IgnoreLoop ) && !this->debug_mode() )
+                return replay_test( vm::Interrupt::Cfl, pc );
+            return Super::test_loop( pc, ctr );
+        }
+
         bool test_crit( vm::CodePointer pc, vm::GenericPointer ptr, int size, int type )
         {
             if ( this->flags_all( _VM_CF_IgnoreCrit ) || this->debug_mode() )
                 return false;
+            if ( _replay )
+                return replay_test( vm::Interrupt::Mem, pc );
 
             auto start = ptr, end = start;
             end.offset( start.offset() + size );
@@ -46,12 +46,34 @@ namespace divine::mc::impl
     {
         using Snapshot = vm::CowHeap::Snapshot;
         using Pool = vm::CowHeap::Pool;
+        using TagPool = brick::mem::SlavePool< Pool >;
 
         Pool &_pool;
         Solver &_solver;
         mutable vm::CowHeap _h1, _h2;
         vm::HeapPointer _root, _path;
-        bool overwrite = false;
+        bool overwrite = false, subsumption = false;
+
+        /* the state of the property automaton, if any (see mc/product.hpp) */
+        mutable TagPool _tags;
+        bool tagged = false;
+
+        void enable_tags()
+        {
+            _tags.attach( _pool );
+            tagged = true;
+        }
+
+        uint32_t tag( Snapshot s ) const
+        {
+            return tagged ? *_tags.template machinePointer< uint32_t >( s ) : 0;
+        }
+
+        void tag( Snapshot s, uint32_t t )
+        {
+            _tags.materialise( s, sizeof( t ), false );
+            *_tags.template machinePointer< uint32_t >( s ) = t;
+        }
 
         void attach( const vm::CowHeap &heap )
         {
@@ -73,6 +95,9 @@ namespace divine::mc::impl
             _root = o._root;
             _path = o._path;
             overwrite = o.overwrite;
+            subsumption = o.subsumption;
+            _tags = o._tags;
+            tagged = o.tagged;
         }
 
         void prepare( Snapshot ) {}
@@ -90,6 +115,8 @@ namespace divine::mc::impl
 
         bool equal_explicit( Snapshot a, Snapshot b ) const
         {
+            if ( tag( a ) != tag( b ) )
+                return false;
             if ( equal_fastpath( a, b ) )
                 return true;
             else
@@ -98,6 +125,8 @@ namespace divine::mc::impl
 
         bool equal_symbolic( Snapshot a, Snapshot b ) const
         {
+            if ( tag( a ) != tag( b ) )
+                return false;
             if ( equal_fastpath( a, b ) )
                 return true;
 
@@ -115,7 +144,8 @@ namespace divine::mc::impl
         auto hash( Snapshot s ) const
         {
             _h1.restore( _pool, s );
-            return mem::hash( _h1, _root );
+            auto h = mem::hash( _h1, _root );
+            return tagged ? h ^ brq::hash( tag( s ) ) : h;
         }
     };
 }
@@ -125,16 +155,33 @@ namespace divine::mc
 
     using Snapshot = vm::CowHeap::Snapshot;
 
+    /* In symbolic mode, states with the same concrete part (and hence the
+     * same hash) form a chain, linked through a slave pool. Each link also
+     * keeps a signature of the path condition of its state: a small Bloom
+     * filter over its clauses, computed on first use. With subsumption
+     * enabled, a new state whose path condition implies that of a stored
+     * state (and whose symbolic values agree) is considered already visited.
+     * Since path conditions mostly grow by adding clauses, only the stored
+     * states whose clauses may all appear in the new one are offered to the
+     * solver; the signatures make this a pair of bit operations. */
+
     template< typename Solver >
     struct Hasher : impl::Hasher< Solver >
     {
         using Super = impl::Hasher< Solver >;
         using SPool = brick::mem::SlavePool< typename Super::Pool >;
+        using ASnap = std::atomic< Snapshot >;
         mutable SPool _sym_next;
 
+        struct Link
+        {
+            ASnap next;
+            std::atomic< uint64_t > sig;
+        };
+
         void prepare( Snapshot s )
         {
-            _sym_next.materialise( s, sizeof( Snapshot ) );
+            _sym_next.materialise( s, sizeof( Link ) );
         }
 
         Hasher( typename Super::Pool &pool, const vm::CowHeap &heap, Solver &solver )
@@ -145,6 +192,30 @@ namespace divine::mc
             : Super( o, pool, solver ), _sym_next( o._sym_next )
         {}
 
+        Link &link( Snapshot s ) const { return *_sym_next.template machinePointer< Link >( s ); }
+
+        uint64_t signature( Snapshot s, vm::CowHeap &heap ) const
+        {
+            auto &sig = link( s ).sig;
+            if ( uint64_t v = sig.load() )
+                return v;
+
+            uint64_t v = 1ull << 63; /* computed */
+            smt::each_clause( heap, this->_path, [&]( const brq::smt_expr< std::vector > &clause )
+            {
+                v |= 1ull << ( brq::hash( clause.base::data(), clause.base::size() ) % 63 );
+            } );
+            sig.store( v );
+            return v;
+        }
+
+        bool subsumes( Snapshot a, Snapshot b, impl::PairExtract &extract ) const
+        {
+            if ( signature( a, this->_h1 ) & ~signature( b, this->_h2 ) )
+                return false;
+            return this->_solver.subsumes( this->_path, extract.pairs, this->_h1, this->_h2 );
+        }
+
         template< typename Cell >
         typename Cell::pointer match( Cell &cell, Snapshot b, mem::hash64_t h ) const
         {
@@ -152,10 +223,11 @@ namespace divine::mc
                 return nullptr;
 
             auto a = cell.fetch();
-
-            using ASnap = std::atomic< Snapshot >;
             ASnap *a_ptr = nullptr;
 
+            if ( this->tag( a ) != this->tag( b ) ) /* the entire chain shares the tag */
+                return nullptr;
+
             if ( this->equal_fastpath( a, b ) )
                 return cell.value();
 
@@ -170,8 +242,7 @@ namespace divine::mc
                 {
                     if ( this->overwrite )
                     {
-                        auto b_next = _sym_next.template machinePointer< ASnap >( b );
-                        b_next->store( _sym_next.template machinePointer< ASnap >( a )->load() );
+                        link( b ).next.store( link( a ).next.load() );
                         if ( a_ptr )
                             a_ptr->store( b );
                         else
@@ -181,7 +252,10 @@ namespace divine::mc
                     return a_ptr ? a_ptr : cell.value();
                 }
 
-                a_ptr = _sym_next.template machinePointer< ASnap >( a );
+                if ( this->subsumption && subsumes( a, b, extract ) )
+                    return a_ptr ? a_ptr : cell.value();
+
+                a_ptr = &link( a ).next;
                 a = a_ptr->load();
                 if ( this->_pool.valid( a ) )
                     this->_h1.restore( this->_pool, a );
@@ -35,8 +35,17 @@ struct Job : ss::Job
     std::function< void( bool ) > _monitor;
     std::function< std::pair< int64_t, int64_t >() > stats = []() { return std::make_pair( 0, 0 ); };
     std::function< int64_t() > queuesize = []() { return 0; };
+    std::function< ThreadStats() > threadstats = []() { return ThreadStats(); };
     std::shared_ptr< ss::Job > _search;
 
+    /* explore the state space in a level-synchronous BFS order, so that the
+     * counterexample (if any) is as short as possible */
+    bool shortest_ce = false;
+
+    /* in liveness checks, only accept cycles which are weakly fair towards
+     * DiOS tasks (this relies on the plain DiOS scheduler, see Couvreur) */
+    bool fair = false;
+
     template< typename Monitor >
     void start( int threads, Monitor monit )
     {
@@ -70,6 +79,18 @@ struct Job : ss::Job
     virtual Result result() { return Result::None; }
     virtual PoolStats poolstats() { return PoolStats(); }
     virtual HashStats hashstats() { return HashStats(); }
+
+    /* the capacity of the state table and the size of a single cell in
+     * bytes (cheap, unlike hashstats), and a way to grow the table ahead of
+     * time; used by ui::Governor */
+    virtual std::pair< int64_t, int64_t > table() { return { 0, 0 }; }
+    virtual void reserve( int64_t /* cells */ ) {}
+
+    Metrics metrics()
+    {
+        return Metrics{ stats(), threadstats(), queuesize(), poolstats(), hashstats() };
+    }
+
     virtual void dbg_fill( DbgCtx & ) {}
     virtual void start( int ) override = 0;
     virtual ~Job() = default;
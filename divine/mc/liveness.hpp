@@ -24,6 +24,13 @@
 #include <divine/mc/trace.hpp>
 #include <brick-query>
 
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
 namespace divine {
 namespace mc {
 
@@ -39,6 +46,47 @@ struct EdgeHasher {
 
 enum class StackItemType { DfsStack, Successors };
 
+/* a concurrent map of parent pointers, split into independently locked shards */
+template< typename State >
+struct ParentMap
+{
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map< uint64_t, State > map;
+    };
+
+    std::array< Shard, 64 > _shards;
+
+    Shard &shard( State s )
+    {
+        return _shards[ brick::bitlevel::mixdown( s.snap.intptr() ) % _shards.size() ];
+    }
+
+    /* set the parent of s, unless it already has one */
+    bool claim( State s, State parent )
+    {
+        auto &sh = shard( s );
+        std::lock_guard< std::mutex > _lock( sh.mutex );
+        return sh.map.emplace( s.snap.intptr(), parent ).second;
+    }
+
+    State at( State s ) { return shard( s ).map.at( s.snap.intptr() ); }
+};
+
+/* a builder which starts the search from a given state */
+template< typename Builder >
+struct Rooted : Builder
+{
+    using State = typename Builder::State;
+    State _root;
+
+    Rooted( const Builder &b, State root ) : Builder( b ), _root( root ) {}
+
+    template< typename Y >
+    void initials( Y yield ) { yield( _root ); }
+};
+
 template< typename Builder >
 struct NestedDFS : ss::Job
 {
@@ -87,6 +135,7 @@ struct NestedDFS : ss::Job
         StackRange lasso_inner_fragment;
         StackRange lasso_outer_fragment;
         std::optional< State > goal;
+        bool error = false; /* the goal is an error state, not a cycle */
     } counterexample;
 
     auto init_state( State &s )
@@ -125,6 +174,7 @@ struct NestedDFS : ss::Job
                     flags.in_outer_stack = true;
                     if ( item.error ) {
                         counterexample.goal = item.state;
+                        counterexample.error = true;
                         counterexample.tail_fragment = StackRange( outer_stack.begin(), outer_stack.end() - 1 );
                         return true;
                     }
@@ -207,6 +257,94 @@ struct NestedDFS : ss::Job
         return false;
     }
 
+    bool visited( State s )
+    {
+        auto &f = *_flagPool.machinePointer< StateFlags >( s.snap );
+        return f.outer_visited || f.inner_visited;
+    }
+
+    using Path = std::pair< std::vector< State >, Label >;
+
+    /* The shortest path (of at least one step) from a state to an edge which
+     * satisfies pred, passing only through states which were already visited
+     * (and hence expanded) by the nested DFS, except for 'avoid'. Returns the
+     * states along the path, not counting the starting one, and the label of
+     * its last edge. This is a level-synchronous BFS (see ss::Order::BFS). */
+    template< typename Pred >
+    std::optional< Path > path( State from, Pred pred, int threads,
+                                std::optional< State > avoid = std::nullopt )
+    {
+        ParentMap< State > parent;
+        std::mutex mutex;
+        std::optional< std::tuple< State, State, Label > > found;
+
+        ss::search( ss::Order::BFS, Rooted< Builder >( _builder, from ), threads, ss::listen(
+            [&]( State f, State t, const Label &l, bool isnew )
+            {
+                if ( pred( t, l ) )
+                {
+                    std::lock_guard< std::mutex > _lock( mutex );
+                    if ( !found )
+                        found.emplace( f, t, l );
+                    return ss::Listen::Terminate;
+                }
+                if ( isnew || t == from || ( avoid && t == *avoid ) || !visited( t ) )
+                    return ss::Listen::Ignore;
+                return parent.claim( t, f ) ? ss::Listen::Process : ss::Listen::Ignore;
+            },
+            []( State ) { return ss::Listen::Process; } ) );
+
+        if ( !found )
+            return std::nullopt;
+
+        auto [ f, t, l ] = *found;
+        Path rv{ { t }, l };
+        for ( ; f != from; f = parent.at( f ) )
+            rv.first.push_back( f );
+        std::reverse( rv.first.begin(), rv.first.end() );
+        return rv;
+    }
+
+    /* The counterexample found by the nested DFS is as long as its stacks,
+     * which can be very long. Instead, take a shortest path from the initial
+     * state to the goal, followed by a shortest accepting cycle through it,
+     * or just a shortest path to an error. Returns the states of the lasso,
+     * starting with the initial state, and the label of its last edge. */
+    std::optional< Path > lasso( int threads )
+    {
+        if ( !counterexample.goal )
+            return std::nullopt;
+
+        auto goal = *counterexample.goal;
+        auto init = _builder._d.initial;
+        Path rv{ { init }, Label() };
+
+        auto append = [&]( auto p )
+        {
+            if ( !p )
+                return false;
+            rv.first.insert( rv.first.end(), p->first.begin(), p->first.end() );
+            rv.second = p->second;
+            return true;
+        };
+
+        auto error = []( State, const Label &l ) { return l.error; };
+        auto stem = [&]( State t, const Label & ) { return t == goal; };
+        auto cycle = [&]( State t, const Label &l ) { return t == goal && l.accepting; };
+        bool ok;
+
+        /* the error state itself was never expanded */
+        if ( counterexample.error )
+            ok = append( path( init, error, threads, goal ) );
+        else
+            ok = ( goal == init || append( path( init, stem, threads ) ) ) &&
+                 append( path( goal, cycle, threads ) );
+
+        if ( !ok )
+            return std::nullopt;
+        return rv;
+    }
+
     void run()
     {
         _builder.initials( [found = false, this] ( State state ) mutable
@@ -233,6 +371,323 @@ struct NestedDFS : ss::Job
     void stop() override {}
 };
 
+/* An SCC-based emptiness check for transition-based generalised Büchi
+ * acceptance (Couvreur, 1999), which works with the acceptance marks carried
+ * by each Label directly, without degeneralisation. This is a Tarjan-style
+ * DFS which keeps a stack of SCC roots, each with the marks collected inside
+ * its (partial) SCC. When a back edge merges roots, their marks are combined,
+ * and once a root holds all the marks, an accepting cycle exists. *
+ * Optionally, only cycles which are weakly fair towards DiOS tasks are
+ * accepted (each task that is enabled all along the cycle must also take a
+ * step on it). Tasks are identified by the first choice of each transition,
+ * which is the one made by the (plain) DiOS scheduler when it picks a task
+ * from its list. Along with the marks, each root then keeps the tasks enabled
+ * in all states of its SCC and the tasks taken on its edges: an SCC has a
+ * fair accepting cycle iff it has all the marks and every task enabled in all
+ * of its states is also taken inside it (a cycle can go through all the
+ * states and edges of an SCC). Like the marks, both sets only ever improve as
+ * the SCC grows, hence the check can be done on the fly. If the number of
+ * tasks varies within an SCC, the indices cannot be matched up and the SCC
+ * is considered fair, so that no counterexample is lost. */
+
+template< typename Builder >
+struct Couvreur : ss::Job
+{
+    using State = typename Builder::State;
+    using Label = typename Builder::Label;
+    using MasterPool = typename vm::CowHeap::SnapPool;
+    using SlavePool = brick::mem::SlavePool< MasterPool >;
+
+    Builder _builder;
+    SlavePool _flagPool;
+    uint64_t _all;
+    bool _fair;
+
+    struct StateFlags
+    {
+        uint32_t index = 0; /* the DFS order, 0 = not yet visited */
+        bool dead:1 = false; /* belongs to a completed SCC */
+    };
+
+    struct Frame
+    {
+        State state;
+        std::vector< std::pair< State, Label > > succs;
+        size_t next = 0;
+        Frame( State s ) : state( s ) {}
+    };
+
+    struct Root
+    {
+        uint32_t index;
+        uint64_t marks, arc; /* collected in the SCC, on the edge entering it */
+        uint64_t enabled, taken, arc_task; /* in all states, on some edge, entering */
+        int tasks; /* in each of the states, -1 if this differs */
+    };
+
+    std::vector< Frame > _dfs;
+    std::vector< Root > _roots;
+    std::vector< State > _active;
+    uint32_t _count = 0;
+
+    /* the counterexample: a path from the initial state and then a cycle
+     * back to its last state (empty if the goal is an error state) */
+    std::vector< State > _tail, _cycle;
+    bool _found = false;
+
+    explicit Couvreur( Builder builder, bool fair = false )
+        : _builder( builder ), _flagPool( _builder.pool() ),
+          _all( _builder.automaton() ? _builder.automaton()->all() : 1 ), _fair( fair )
+    {}
+
+    StateFlags &flags( State s ) { return *_flagPool.machinePointer< StateFlags >( s.snap ); }
+
+    void init_state( State s )
+    {
+        _flagPool.materialise( s.snap, sizeof( StateFlags ) );
+        new ( &flags( s ) ) StateFlags();
+    }
+
+    /* without an automaton, the monitor's accepting bit is the only mark */
+    uint64_t marks( const Label &l ) { return _builder.automaton() ? l.marks : l.accepting; }
+
+    /* the task which makes the transition, as a bit (0 if unknown) */
+    static uint64_t task( const Label &l )
+    {
+        return l.stack.empty() || l.stack[ 0 ].taken >= 64 ? 0 : 1ull << l.stack[ 0 ].taken;
+    }
+
+    static int tasks( const Label &l )
+    {
+        return l.stack.empty() ? 0 : l.stack[ 0 ].total <= 64 ? l.stack[ 0 ].total : -1;
+    }
+
+    uint64_t enabled( State s )
+    {
+        uint64_t rv = 0;
+        _builder.edges( s, [&]( State to, const Label &l, bool isnew )
+            {
+                if ( isnew )
+                    init_state( to );
+                rv |= task( l );
+            } );
+        return rv;
+    }
+
+    void push( State s, uint64_t arc, uint64_t arc_task )
+    {
+        Root root{ ++ _count, 0, arc, 0, 0, arc_task, 0 };
+        flags( s ).index = _count;
+        _active.push_back( s );
+        _dfs.emplace_back( s );
+        _builder.edges( s, [&]( State to, const Label &l, bool isnew )
+            {
+                if ( isnew )
+                    init_state( to );
+                _dfs.back().succs.emplace_back( to, l );
+                root.enabled |= task( l );
+                root.tasks = tasks( l );
+            } );
+        _roots.push_back( root );
+        _builder._d.sync();
+    }
+
+    void pop()
+    {
+        auto s = _dfs.back().state;
+        _dfs.pop_back();
+
+        if ( _roots.back().index != flags( s ).index )
+            return;
+
+        _roots.pop_back();
+        while ( true )
+        {
+            auto t = _active.back();
+            _active.pop_back();
+            flags( t ).dead = true;
+            if ( t == s )
+                break;
+        }
+    }
+
+    static void absorb( Root &into, const Root &r )
+    {
+        into.marks |= r.marks | r.arc;
+        into.taken |= r.taken | r.arc_task;
+        into.enabled &= r.enabled;
+        if ( into.tasks != r.tasks )
+            into.tasks = -1;
+    }
+
+    bool accepting( const Root &r )
+    {
+        if ( ( r.marks & _all ) != _all )
+            return false;
+        return !_fair || r.tasks < 0 || !( r.enabled & ~r.taken );
+    }
+
+    bool merge( State to, uint64_t arc, uint64_t arc_task )
+    {
+        uint32_t index = flags( to ).index;
+
+        while ( _roots.back().index > index )
+        {
+            auto r = _roots.back();
+            _roots.pop_back();
+            absorb( _roots.back(), r );
+        }
+
+        _roots.back().marks |= arc;
+        _roots.back().taken |= arc_task;
+        return accepting( _roots.back() );
+    }
+
+    bool dfs( State from )
+    {
+        init_state( from );
+        push( from, 0, 0 );
+
+        while ( !_dfs.empty() )
+        {
+            auto &top = _dfs.back();
+
+            if ( top.next == top.succs.size() )
+            {
+                pop();
+                continue;
+            }
+
+            auto [ to, label ] = top.succs[ top.next ++ ];
+            auto &f = flags( to );
+
+            if ( label.error )
+            {
+                for ( auto &fr : _dfs )
+                    _tail.push_back( fr.state );
+                _tail.push_back( to );
+                return true;
+            }
+
+            if ( !f.index )
+                push( to, marks( label ), task( label ) );
+            else if ( !f.dead && merge( to, marks( label ), task( label ) ) )
+            {
+                for ( auto &fr : _dfs )
+                    _tail.push_back( fr.state );
+                lasso();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /* the shortest path (of at least one step) from a state to an edge
+     * accepted by pred, not counting the starting state, and staying within
+     * the states accepted by in */
+    template< typename In, typename Pred >
+    std::vector< State > path( State from, In in, Pred pred )
+    {
+        std::map< uint64_t, State > parent;
+        std::deque< State > queue{ from };
+        std::vector< State > rv;
+
+        while ( rv.empty() && !queue.empty() )
+        {
+            auto s = queue.front();
+            queue.pop_front();
+
+            _builder.edges( s, [&]( State to, const Label &l, bool isnew )
+                {
+                    if ( isnew )
+                        init_state( to );
+                    if ( !rv.empty() || !in( to ) )
+                        return;
+                    if ( pred( to, l ) )
+                    {
+                        rv.push_back( to );
+                        for ( auto t = s; t != from; t = parent.at( t.snap.intptr() ) )
+                            rv.push_back( t );
+                        std::reverse( rv.begin(), rv.end() );
+                    }
+                    else if ( to != from && parent.emplace( to.snap.intptr(), s ).second )
+                        queue.push_back( to );
+                } );
+        }
+
+        ASSERT( !rv.empty() );
+        return rv;
+    }
+
+    /* a cycle through the top of the DFS stack which stays within the
+     * accepting SCC and collects all the marks along the way; with fairness,
+     * each task must also either take a step on the cycle, or be disabled in
+     * one of its states */
+    void lasso()
+    {
+        auto goal = _dfs.back().state;
+        uint32_t root = _roots.back().index;
+        uint64_t missing = _all;
+        int count = _roots.back().tasks;
+        uint64_t unfair = !_fair || count <= 0 ? 0 : count == 64 ? ~0ull : ( 1ull << count ) - 1;
+        std::map< uint64_t, uint64_t > en; /* the enabled tasks in each state of the SCC */
+
+        if ( unfair )
+        {
+            for ( auto s : _active )
+                if ( flags( s ).index >= root )
+                    en[ s.snap.intptr() ] = enabled( s );
+            unfair &= en[ goal.snap.intptr() ];
+        }
+
+        auto in = [&]( State s ) { auto &f = flags( s ); return f.index >= root && !f.dead; };
+        auto extend = [&]( auto pred )
+        {
+            for ( auto s : path( _cycle.empty() ? goal : _cycle.back(), in, pred ) )
+                _cycle.push_back( s );
+        };
+
+        while ( missing || unfair )
+            extend( [&]( State to, const Label &l )
+                    {
+                        uint64_t disabled = unfair ? unfair & ~en.at( to.snap.intptr() ) : 0;
+                        bool rv = ( marks( l ) & missing ) || ( task( l ) & unfair ) || disabled;
+                        missing &= ~marks( l );
+                        unfair &= ~task( l ) & ~disabled;
+                        return rv;
+                    } );
+
+        if ( _cycle.empty() || _cycle.back() != goal )
+            extend( [&]( State to, const Label & ) { return to == goal; } );
+    }
+
+    void run()
+    {
+        _builder.initials( [&]( State state )
+            {
+                if ( !_found )
+                    _found = dfs( state );
+            } );
+    }
+
+    std::future< void > _thread;
+
+    void start( int thread_count ) override
+    {
+        if ( thread_count != 1 )
+            throw new std::runtime_error( "The SCC-based search only supports one thread." );
+        _thread = std::async( [&]{ run(); } );
+    }
+
+    void wait() override
+    {
+        _thread.get();
+    }
+
+    void stop() override {}
+};
+
 template< typename Next, typename Builder_ = ExplicitBuilder >
 struct Liveness : Job
 {
@@ -252,11 +707,18 @@ struct Liveness : Job
         _ex.start();
     }
 
+    /* the search itself is sequential, the threads are only used to make the
+     * counterexample shorter once the search is over */
     void start( int threads ) override
     {
+        stats = [=] { return std::pair( _ex._d.total_states->load(), _ex._d.total_instructions->load() ); };
+        threadstats = [=] { return ThreadStats{ stats() }; };
+
+        if ( _ex.automaton() || fair )
+            return start_scc();
+
         auto *search = new NestedDFS( _ex );
         _search.reset( search );
-        stats = [=] { return std::pair( _ex._d.total_states->load(), _ex._d.total_instructions->load() ); };
         queuesize = [=] { return search->outer_stack.size() + search->inner_stack.size(); };
 
         _get_trace = [=]() mutable
@@ -265,6 +727,15 @@ struct Liveness : Job
             auto &ce = search->counterexample;
             StateTrace trace;
 
+            if ( auto lasso = search->lasso( threads ) )
+            {
+                auto &[ states, label ] = *lasso;
+                for ( auto s : states )
+                    trace.emplace_back( s.snap, std::nullopt );
+                trace.back().second = label; /* the accepting (or error) edge */
+                return trace;
+            }
+
             for ( auto &i : ce.lasso_outer_fragment )
                 if ( i.type == StackItemType::DfsStack )
                     trace.emplace_back( i.state.snap, std::nullopt );
@@ -290,7 +761,29 @@ struct Liveness : Job
 
         _error_found = [=]() { return search->counterexample.goal.has_value(); };
 
-        search->start( threads );
+        search->start( 1 );
+    }
+
+    /* properties given as a (generalised) automaton on the host, and fair
+     * emptiness checks */
+    void start_scc()
+    {
+        auto *search = new Couvreur< Builder >( _ex, fair );
+        _search.reset( search );
+        queuesize = [=] { return search->_dfs.size(); };
+
+        _get_trace = [=]
+        {
+            StateTrace trace;
+            for ( auto s : search->_tail )
+                trace.emplace_back( s.snap, std::nullopt );
+            for ( auto s : search->_cycle )
+                trace.emplace_back( s.snap, std::nullopt );
+            return trace;
+        };
+
+        _error_found = [=] { return search->_found; };
+        search->start( 1 );
     }
 
     void dbg_fill( DbgCtx &dbg ) override { dbg.load( _ex.pool(), _ex.context() ); }
@@ -312,6 +805,12 @@ struct Liveness : Job
         return PoolStats{ { "snapshot memory", _ex.pool().stats() },
                           { "fragment memory", _ex.context().heap().mem_stats() } };
     }
+
+    virtual HashStats hashstats() override
+    {
+        return HashStats{ { "snapshot table", _ex._d.states.stats() },
+                          { "fragment table", _ex.context().heap().ht_stats() } };
+    }
 };
 
 }
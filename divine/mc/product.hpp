@@ -0,0 +1,109 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/ltl/buchi.hpp>
+#include <brick-except>
+#include <brick-assert>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* A property automaton which runs on the host, in lockstep with the program,
+ * instead of being compiled into the program as a monitor (cf. `divine ltlc`).
+ * The automaton is a transition-based generalised Büchi automaton (TGBA2 from
+ * divine::ltl) and its transitions are guarded by atomic propositions, each
+ * of which names a global variable of the program, and holds in a state where
+ * that variable is nonzero. Guards are evaluated in the source state of each
+ * program transition.
+ *
+ * The state of the automaton is kept as a small integer tag attached to the
+ * snapshot of the program state (see impl::Hasher), which takes part in state
+ * hashing and comparison. Acceptance is not degeneralised: each transition of
+ * the product carries the set of acceptance marks of the automaton transition
+ * it was built from, and the emptiness check (see Couvreur in liveness.hpp)
+ * looks for an SCC which contains all the marks. */
+
+namespace divine::mc
+{
+    struct Automaton
+    {
+        using Tag = uint32_t;
+
+        struct Edge
+        {
+            int target;
+            uint64_t pos = 0, neg = 0; /* propositions that must (not) hold */
+            uint64_t accepting = 0;    /* acceptance sets this edge belongs to */
+        };
+
+        std::vector< std::vector< Edge > > _states;
+        std::vector< std::string > _props;
+        int _start = 0, _sets = 0;
+
+        Automaton( const ltl::TGBA2 &a )
+            : _start( a.start ), _sets( a.nAcceptingSets )
+        {
+            if ( a.allTrivialLiterals.size() > 64 )
+                brq::raise() << "at most 64 atomic propositions are supported";
+            if ( _sets > 64 )
+                brq::raise() << "at most 64 acceptance sets are supported";
+
+            for ( auto &l : a.allTrivialLiterals )
+                _props.push_back( l->string() );
+
+            _states.resize( a.states.size() );
+            for ( size_t s = 0; s < a.states.size(); ++s )
+                for ( auto &t : a.states[ s ] )
+                {
+                    Edge e{ int( t.target ) };
+                    for ( auto [ positive, prop ] : t.label )
+                        ( positive ? e.pos : e.neg ) |= 1ull << prop;
+                    for ( auto set : t.accepting )
+                        e.accepting |= 1ull << set;
+                    _states[ s ].push_back( e );
+                }
+        }
+
+        const std::vector< std::string > &props() const { return _props; }
+        int sets() const { return _sets; }
+
+        /* the marks an accepting cycle must collect */
+        uint64_t all() const { return _sets == 64 ? ~0ull : ( 1ull << _sets ) - 1; }
+
+        /* tag 0 is reserved for states without an automaton component */
+        Tag tag( int state ) const { return 1 + state; }
+        int state( Tag t ) const { ASSERT( t ); return t - 1; }
+        Tag initial() const { return tag( _start ); }
+
+        /* Calls yield( tag, marks ) for each transition of the automaton
+         * enabled under the given valuation of the propositions (bit i set
+         * means that the i-th proposition holds). */
+        template< typename Y >
+        void step( Tag t, uint64_t valuation, Y yield ) const
+        {
+            for ( auto &e : _states[ state( t ) ] )
+                if ( ( valuation & e.pos ) == e.pos && !( valuation & e.neg ) )
+                    yield( tag( e.target ), e.accepting );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
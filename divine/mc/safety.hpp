@@ -23,40 +23,128 @@
 #include <divine/mc/trace.hpp>
 #include <divine/mc/bitcode.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
 namespace divine::mc
 {
 
 template< typename Next, typename Builder >
 struct Safety : Job
 {
-    using Parent = std::atomic< vm::CowHeap::Snapshot >;
+    using Snapshot = vm::CowHeap::Snapshot;
     using MasterPool = typename vm::CowHeap::SnapPool;
     using SlavePool = brick::mem::SlavePool< MasterPool >;
-    using StateTrace = mc::StateTrace< Builder >;
+    using EdgePool = brick::mem::Pool<>;
+    using Label = typename Builder::Label;
+
+    /* Each new state remembers the state it was first reached from, and the
+     * choices and interrupts of that edge, so that a counterexample can be
+     * rebuilt by re-executing just the edges along the path (cf. replay() in
+     * trace.hpp). Edges which need neither are not stored at all. The depth
+     * is the length of the path to the state along the parent pointers. */
+    struct Parent
+    {
+        std::atomic< Snapshot > snap;
+        EdgePool::Pointer edge;
+        uint32_t depth;
+    };
+
+    struct EdgeHeader
+    {
+        uint16_t choices, interrupts;
+    };
 
     Builder _ex;
     SlavePool _ext;
+    EdgePool _edges;
     Next _next;
 
+    std::mutex _error_mutex;
     bool _error_found;
+    uint32_t _error_depth;
     typename Builder::State _error, _error_to;
-    typename Builder::Label _error_label;
+    Label _error_label;
+
+    static EdgePool::Pointer record( EdgePool &pool, const Label &l )
+    {
+        if ( l.stack.empty() && l.interrupts.empty() )
+            return EdgePool::Pointer();
+
+        ASSERT_LEQ( l.stack.size(), std::numeric_limits< uint16_t >::max() );
+        ASSERT_LEQ( l.interrupts.size(), std::numeric_limits< uint16_t >::max() );
+        int cs = l.stack.size() * sizeof( vm::Choice ),
+            is = l.interrupts.size() * sizeof( vm::Interrupt );
+
+        auto p = pool.allocate( sizeof( EdgeHeader ) + cs + is );
+        auto hdr = pool.machinePointer< EdgeHeader >( p );
+        hdr->choices = l.stack.size();
+        hdr->interrupts = l.interrupts.size();
+        std::memcpy( pool.machinePointer< char >( p, sizeof( EdgeHeader ) ), l.stack.data(), cs );
+        std::memcpy( pool.machinePointer< char >( p, sizeof( EdgeHeader ) + cs ),
+                     l.interrupts.data(), is );
+        return p;
+    }
+
+    vm::Step step( EdgePool::Pointer p )
+    {
+        vm::Step rv;
+        if ( !p.slab() )
+            return rv;
+
+        auto hdr = *_edges.machinePointer< EdgeHeader >( p );
+        auto data = _edges.machinePointer< char >( p, sizeof( EdgeHeader ) );
+
+        for ( int i = 0; i < hdr.choices; ++i, data += sizeof( vm::Choice ) )
+        {
+            vm::Choice c( 0, 0 );
+            std::memcpy( &c, data, sizeof( c ) );
+            rv.choices.push_back( c );
+        }
+
+        for ( int i = 0; i < hdr.interrupts; ++i, data += sizeof( vm::Interrupt ) )
+        {
+            vm::Interrupt in;
+            std::memcpy( &in, data, sizeof( in ) );
+            rv.interrupts.push_back( in );
+        }
+
+        return rv;
+    }
+
+    uint32_t depth( Snapshot s )
+    {
+        if ( s == _ex._d.initial.snap )
+            return 0;
+        return _ext.machinePointer< Parent >( s )->depth;
+    }
 
     auto make_search()
     {
         return ss::make_search(
             _ex, ss::listen(
-                [&]( auto from, auto to, auto label, bool isnew )
+                [&, edges = _edges]( auto from, auto to, auto label, bool isnew ) mutable
                 {
                     if ( isnew )
                     {
-                        _ext.materialise( to.snap, sizeof( from ) );
+                        _ext.materialise( to.snap, sizeof( Parent ) );
                         Parent &parent = *_ext.machinePointer< Parent >( to.snap );
-                        parent = from.snap;
+                        parent.snap = from.snap;
+                        parent.edge = record( edges, label );
+                        parent.depth = depth( from.snap ) + 1;
                     }
                     if ( label.error )
                     {
+                        /* with a level-synchronous search, all errors found
+                         * concurrently are equally far from the initial state,
+                         * but keep the closest one anyway */
+                        std::lock_guard< std::mutex > _lock( _error_mutex );
+                        if ( _error_found && _error_depth <= depth( from.snap ) )
+                            return ss::Listen::Terminate;
                         _error_found = true;
+                        _error_depth = depth( from.snap );
                         _error = from; /* the error edge may not be the parent of 'to' */
                         _error_to = to;
                         _error_label = label;
@@ -94,8 +182,19 @@ struct Safety : Job
             } );
             return std::make_pair( st, mip );
         };
+        threadstats = [=]()
+        {
+            ThreadStats rv;
+            search->ws_each( [&]( auto &bld, auto & )
+            {
+                rv.emplace_back( bld._d.local_states, bld._d.local_instructions );
+            } );
+            return rv;
+        };
         queuesize = [=]() { return search->qsize(); };
 
+        if ( shortest_ce )
+            search->order( ss::Order::BFS );
         search->start( threads );
     }
 
@@ -104,16 +203,22 @@ struct Safety : Job
         if ( !_error_found )
             return Trace();
 
-        StateTrace rv;
-        rv.emplace_front( _error_to.snap, _error_label );
-        auto i = _error.snap;
-        while ( i != _ex._d.initial.snap )
+        std::vector< std::pair< Snapshot, vm::Step > > path;
+        path.emplace_back( _error.snap, vm::Step() );
+        std::copy( _error_label.stack.begin(), _error_label.stack.end(),
+                   std::back_inserter( path.back().second.choices ) );
+        std::copy( _error_label.interrupts.begin(), _error_label.interrupts.end(),
+                   std::back_inserter( path.back().second.interrupts ) );
+
+        for ( auto i = _error.snap; i != _ex._d.initial.snap; )
         {
-            rv.emplace_front( i, std::nullopt );
-            i = *_ext.machinePointer< vm::CowHeap::Snapshot >( i );
+            Parent &parent = *_ext.machinePointer< Parent >( i );
+            i = parent.snap;
+            path.emplace_back( i, step( parent.edge ) );
         }
-        rv.emplace_front( _ex._d.initial.snap, std::nullopt );
-        return mc::trace( _ex, rv );
+
+        std::reverse( path.begin(), path.end() );
+        return mc::replay( _ex, path );
     }
 
     void dbg_fill( DbgCtx &dbg ) override { dbg.load( _ex.pool(), _ex.context() ); }
@@ -146,6 +251,14 @@ struct Safety : Job
         return HashStats{ { "snapshot table", _ex._d.states.stats() },
                           { "fragment table", _ex.context().heap().ht_stats() } };
     }
+
+    std::pair< int64_t, int64_t > table() override
+    {
+        using Cell = typename decltype( _ex._d.states )::Cell;
+        return { _ex._d.states.capacity(), sizeof( Cell ) };
+    }
+
+    void reserve( int64_t cells ) override { _ex.reserve( cells ); }
 };
 
 }
@@ -0,0 +1,136 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/mc/hasher.hpp>
+#include <divine/vm/memory.tpp>
+
+namespace divine::t_mc
+{
+    /* pretends that no two symbolic states are equal, and that a state
+     * subsumes another whenever asked */
+    struct SubsumeSolver
+    {
+        int queries = 0;
+
+        bool equal( vm::HeapPointer, smt::solver::SymPairs &, vm::CowHeap &, vm::CowHeap & ) { return false; }
+        bool subsumes( vm::HeapPointer, smt::solver::SymPairs &, vm::CowHeap &, vm::CowHeap & )
+        {
+            ++ queries;
+            return true;
+        }
+    };
+
+    /* The states share the same concrete part (the root object), hence they
+     * land in the same chain, but differ in their path conditions: each
+     * clause is a marked object holding some (opaque) bytes. */
+    struct TestHasher
+    {
+        using Hasher = mc::Hasher< SubsumeSolver >;
+        using HT = brq::concurrent_hash_set< vm::CowHeap::Snapshot >;
+        using PointerV = vm::value::Pointer;
+
+        vm::CowHeap heap;
+        vm::CowHeap::Pool pool;
+        SubsumeSolver solver;
+        PointerV root, path;
+        std::vector< PointerV > clauses;
+
+        TestHasher()
+        {
+            root = heap.make( 16 );
+            path = heap.make( vm::PointerBytes );
+            heap.write( root.cooked(), vm::value::Int< 32 >( 7 ) );
+        }
+
+        Hasher hasher()
+        {
+            heap.snapshot( pool ); /* the heap can only be copied when clean */
+            Hasher h( pool, heap, solver );
+            h._root = root.cooked();
+            h._path = path.cooked();
+            h.subsumption = true;
+            return h;
+        }
+
+        void clause( uint8_t c )
+        {
+            auto p = heap.make( 4, _VM_PL_Heap + 1 );
+            heap.write( p.cooked(), vm::value::Int< 32 >( 0x100 | c ) );
+            clauses.push_back( p );
+        }
+
+        /* a state whose path condition consists of the given clauses */
+        vm::CowHeap::Snapshot state( std::vector< int > pc )
+        {
+            heap.resize( path.cooked(), pc.size() * vm::PointerBytes );
+            auto p = path;
+            for ( int c : pc )
+                heap.write_shift( p, clauses[ c ] );
+            return heap.snapshot( pool );
+        }
+
+        /* like Builder::store: a state appended to a chain is new as well */
+        bool insert( HT &ht, Hasher &h, vm::CowHeap::Snapshot s )
+        {
+            h.prepare( s );
+            return ht.insert( s, h )->load() == s;
+        }
+
+        TEST( subsumed )
+        {
+            clause( 1 ); clause( 2 );
+            auto h = hasher();
+            HT ht;
+
+            ASSERT( insert( ht, h, state( { 0 } ) ) );
+            ASSERT( !insert( ht, h, state( { 0, 1 } ) ) ); /* a stronger path condition */
+            ASSERT_EQ( solver.queries, 1 );
+        }
+
+        TEST( signature_mismatch )
+        {
+            auto h = hasher();
+            auto sig = [&]( auto s )
+            {
+                h.prepare( s );
+                h._h1.restore( pool, s );
+                return h.signature( s, h._h1 );
+            };
+
+            /* pick two clauses which set different bits of the signature */
+            clause( 0 );
+            auto first = sig( state( { 0 } ) );
+            for ( uint8_t c = 1; clauses.size() < 2; ++c )
+            {
+                clause( c );
+                if ( sig( state( { 1 } ) ) == first )
+                    clauses.pop_back();
+            }
+
+            HT ht;
+            ASSERT( insert( ht, h, state( { 0, 1 } ) ) );
+            ASSERT( insert( ht, h, state( { 0 } ) ) ); /* a weaker path condition */
+            ASSERT( insert( ht, h, state( { 1 } ) ) );
+            ASSERT_EQ( solver.queries, 0 );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -0,0 +1,69 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/mc/liveness.hpp>
+#include <divine/mc/job.tpp>
+#include <divine/mc/t-builder.hpp>
+
+namespace divine::t_mc
+{
+    struct TestLiveness
+    {
+        /* A chain 0 → 1 → ... → 10, with a shortcut from each state to 10,
+         * and an accepting cycle 10 → 11 → 10. The first choice is to go
+         * along the chain, hence that is where the nested DFS finds the
+         * cycle. */
+        static auto chain()
+        {
+            std::stringstream p;
+            p << "void __sched() {" << std::endl
+              << "    int *r = __vm_ctl_get( " << _VM_CR_State << " );" << std::endl
+              << "    if ( *r < 10 ) *r = __vm_choose( 2 ) ? 10 : *r + 1;" << std::endl
+              << "    else if ( *r == 10 ) *r = 11;" << std::endl
+              << "    else { *r = 10; __vm_ctl_flag( 0, " << _VM_CF_Accepting << " ); }" << std::endl
+              << "    __vm_ctl_set( " << _VM_CR_Frame << ", 0 );" << std::endl
+              << "}" << std::endl
+              << "void __boot( void *environ ) {"
+              << "    __vm_ctl_set( " << _VM_CR_Scheduler << ", __sched );"
+              << "    void *e = __vm_obj_make( sizeof( int ), " << _VM_PT_Heap << " );"
+              << "    __vm_ctl_set( " << _VM_CR_State << ", e );"
+              << "    int *r = e; *r = 0;"
+              << "    __vm_ctl_set( " << _VM_CR_Frame << ", 0 ); }" << std::endl;
+            return prog( p.str() );
+        }
+
+        TEST( lasso )
+        {
+            auto live = mc::make_job< mc::Liveness >( chain(), ss::passive_listen() );
+            live->start( 2 );
+            live->wait();
+            ASSERT_EQ( live->result(), mc::Result::Error );
+
+            /* the DFS stack goes through the whole chain (12 edges or more),
+             * the lasso takes the shortcut: 0 → 10, then around the cycle
+             * (possibly entering it at 11 instead) */
+            auto trace = live->ce_trace();
+            ASSERT_LEQ( 3, trace.steps.size() );
+            ASSERT_LEQ( trace.steps.size(), 4 );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -0,0 +1,132 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/mc/product.hpp>
+#include <divine/ltl/ltl.hpp>
+
+#include <map>
+#include <set>
+
+namespace divine::t_mc
+{
+    struct product
+    {
+        using Tag = mc::Automaton::Tag;
+
+        static mc::Automaton automaton( std::string f, bool negate )
+        {
+            ltl::TGBA2 a = ltl::ltlToTGBA2( ltl::LTL::parse( f ), negate );
+            return mc::Automaton( a );
+        }
+
+        static uint64_t valuation( const mc::Automaton &a, std::set< std::string > hold )
+        {
+            uint64_t v = 0;
+            for ( size_t i = 0; i < a.props().size(); ++i )
+                if ( hold.count( a.props()[ i ] ) )
+                    v |= 1ull << i;
+            return v;
+        }
+
+        /* is there an accepting run on the infinite word which repeats the
+         * given sequence of valuations forever? */
+        static bool accepts( const mc::Automaton &a, std::vector< uint64_t > word )
+        {
+            using Node = std::pair< Tag, size_t >;
+            std::map< Node, std::vector< std::pair< Node, uint64_t > > > succ;
+            std::vector< Node > todo{ { a.initial(), 0 } };
+            std::set< Node > seen( todo.begin(), todo.end() );
+
+            while ( !todo.empty() )
+            {
+                auto n = todo.back();
+                todo.pop_back();
+                a.step( n.first, word[ n.second ], [&]( Tag t, uint64_t marks )
+                {
+                    Node m( t, ( n.second + 1 ) % word.size() );
+                    succ[ n ].emplace_back( m, marks );
+                    if ( seen.insert( m ).second )
+                        todo.push_back( m );
+                } );
+            }
+
+            auto reaches = [&]( Node from, Node to )
+            {
+                std::set< Node > visited{ from };
+                std::vector< Node > stack{ from };
+                while ( !stack.empty() )
+                {
+                    auto n = stack.back();
+                    stack.pop_back();
+                    if ( n == to )
+                        return true;
+                    for ( auto [ m, acc ] : succ[ n ] )
+                        if ( visited.insert( m ).second )
+                            stack.push_back( m );
+                }
+                return false;
+            };
+
+            /* an edge lies in the SCC of n iff both its ends reach n and back */
+            for ( auto &[ n, _ ] : succ )
+            {
+                uint64_t marks = 0;
+                bool cycle = false;
+                for ( auto &[ u, out ] : succ )
+                    for ( auto [ v, m ] : out )
+                        if ( reaches( n, u ) && reaches( v, n ) )
+                            marks |= m, cycle = true;
+                if ( cycle && ( marks & a.all() ) == a.all() )
+                    return true;
+            }
+            return false;
+        }
+
+        TEST( props )
+        {
+            auto a = automaton( "G ( a U b )", false );
+            ASSERT_EQ( a.props().size(), 2 );
+            ASSERT_EQ( a.state( a.initial() ), a._start );
+        }
+
+        TEST( globally )
+        {
+            auto a = automaton( "G a", true ); /* counterexamples to G a */
+            auto yes = valuation( a, { "a" } ), no = valuation( a, {} );
+            ASSERT( !accepts( a, { yes } ) );
+            ASSERT( accepts( a, { no } ) );
+            ASSERT( accepts( a, { yes, yes, no } ) );
+        }
+
+        TEST( generalised )
+        {
+            auto a = automaton( "G F a && G F b", false );
+            auto va = valuation( a, { "a" } ), vb = valuation( a, { "b" } ),
+                 none = valuation( a, {} );
+            ASSERT_EQ( a.sets(), 2 );
+            ASSERT( !accepts( a, { va } ) );
+            ASSERT( !accepts( a, { vb, none } ) );
+            ASSERT( accepts( a, { va, none, vb } ) );
+            ASSERT( accepts( a, { va | vb } ) );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -40,5 +40,45 @@ namespace divine::t_mc
             ASSERT_EQ( edgecount, 4 );
             ASSERT_EQ( statecount, 5 );
         }
+
+        TEST( counterexample )
+        {
+            auto bc = prog_int( "2", "*r - 1 - __vm_choose( 2 )" );
+            auto safe = mc::make_job< mc::Safety >( bc, ss::passive_listen() );
+            safe->start( 1 );
+            safe->wait();
+            ASSERT_EQ( safe->result(), mc::Result::Error );
+
+            /* the trace is rebuilt from the choices recorded along the path */
+            auto trace = safe->ce_trace();
+            ASSERT( trace.final );
+            ASSERT( !trace.steps.empty() );
+
+            /* the scheduler prints "foo" exactly once on each edge */
+            ASSERT_EQ( std::count( trace.labels.begin(), trace.labels.end(), "foo" ),
+                       trace.steps.size() );
+
+            int r = 2;
+            for ( auto &step : trace.steps )
+            {
+                ASSERT_LEQ( 0, r );
+                ASSERT_EQ( step.choices.size(), 1 );
+                ASSERT_EQ( step.choices.front().total, 2 );
+                r -= 1 + step.choices.front().taken;
+            }
+            ASSERT_LT( r, 0 );
+        }
+
+        TEST( shortest )
+        {
+            /* taking 2 steps at a time, an error is 3 edges away */
+            auto bc = prog_int( "4", "*r - 1 - __vm_choose( 2 )" );
+            auto safe = mc::make_job< mc::Safety >( bc, ss::passive_listen() );
+            safe->shortest_ce = true;
+            safe->start( 2 );
+            safe->wait();
+            ASSERT_EQ( safe->result(), mc::Result::Error );
+            ASSERT_EQ( safe->ce_trace().steps.size(), 3 );
+        }
     };
 }
@@ -24,6 +24,7 @@
 #include <divine/dbg/util.hpp>
 #include <divine/ss/search.hpp>
 
+#include <algorithm>
 #include <optional>
 
 namespace divine::mc
@@ -60,6 +61,34 @@ void backtrace( BT bt, Fmt fmt, Dbg &dbg, vm::CowSnapshot snap, int maxdepth = 1
     dbg::backtrace( bt, fmt, dn, visited, stacks, maxdepth );
 }
 
+/* Build a trace by re-executing only the transitions along a path. Each item
+ * of the path is the source state of a transition, along with the choices
+ * and interrupts recorded when the transition was first explored. Unlike
+ * trace() below, this does not need to search the state space again. */
+template< typename Explore >
+Trace replay( Explore &ex, const std::vector< std::pair< vm::CowSnapshot, vm::Step > > &path )
+{
+    Trace t;
+    ex.context().enable_debug();
+
+    for ( auto &[ from, step ] : path )
+    {
+        auto label = ex.replay( from, step );
+        ASSERT( std::equal( label.stack.begin(), label.stack.end(),
+                            step.choices.begin(), step.choices.end() ) );
+        for ( auto l : label.trace )
+            t.labels.push_back( l );
+        t.steps.push_back( step );
+        if ( label.error )
+            t.final = from;
+    }
+
+    if ( !t.final )
+        std::cerr << "W: Failed to find an error label. Probably a bad trace." << std::endl;
+
+    return t;
+}
+
 // LabelComparer: check if the label in the trace is equal to the label of an edge (in this order)
 template< typename Explore, typename Label, typename LabelComparer = std::equal_to< Label > >
 Trace trace( Explore &ex, LabelledTrace< Label > states, LabelComparer comparer = LabelComparer() )
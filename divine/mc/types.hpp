@@ -67,6 +67,17 @@ namespace divine::mc
 
     using PoolStats = std::map< std::string, brick::mem::Stats >;
     using HashStats = std::map< std::string, brq::hash_set_stats >;
+    using ThreadStats = std::vector< std::pair< int64_t, int64_t > >; /* states, instructions */
+
+    /* a snapshot of a running search, see ui::make_metrics */
+    struct Metrics
+    {
+        std::pair< int64_t, int64_t > total;
+        ThreadStats threads;
+        int64_t queued = 0;
+        PoolStats pools;
+        HashStats tables;
+    };
 
     struct divm_timer_tag;
     struct hash_timer_tag;
@@ -3,16 +3,29 @@
 
 DIVINE_RELAX_WARNINGS
 #include <llvm/IR/Module.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 DIVINE_UNRELAX_WARNINGS
 
 #include <brick-fs>
+#include <map>
+#include <mutex>
 
 namespace divine {
 namespace rt {
 
 using namespace cc;
 
-void DiosCC::link_dios_config( std::string n, std::string lamp )
+void DiosCC::link_dios_libs()
+{
+    for ( int i = 0; i < 3; ++i )
+    {
+        linkLib( "dios" );
+        linkLib( "dios_divm" );
+        linkLibs( rt::DiosCC::defaultDIVINELibs );
+    }
+}
+
+void DiosCC::link_runtime( std::string n, std::string lamp )
 {
     linkEntireArchive( "rst" );
     auto mod = load_object( find_object( "config/" + n ) );
@@ -21,12 +34,79 @@ void DiosCC::link_dios_config( std::string n, std::string lamp )
     if ( !lamp.empty() )
         link( load_object( find_object( "lamp/" + lamp ) ) );
 
-    for ( int i = 0; i < 3; ++i )
+    link_dios_libs();
+}
+
+namespace
+{
+    std::mutex prelinked_mutex;
+    std::map< std::pair< std::string, std::string >, std::string > prelinked;
+}
+
+std::string DiosCC::prelinked_runtime( std::string n, std::string lamp, std::string cache )
+{
+    std::lock_guard< std::mutex > _lock( prelinked_mutex );
+    auto &bc = prelinked[ { n, lamp } ];
+
+    if ( bc.empty() && !cache.empty() && brq::file_exists( cache ) )
+        bc = brq::read_file( cache );
+
+    if ( bc.empty() )
     {
-        linkLib( "dios" );
-        linkLib( "dios_divm" );
-        linkLibs( rt::DiosCC::defaultDIVINELibs );
+        DiosCC drv( std::make_shared< llvm::LLVMContext >() );
+        drv.link_runtime( n, lamp );
+        bc = drv.serialize();
+
+        if ( !cache.empty() )
+            try
+            {
+                auto tmp = brq::temp_name( cache );
+                brq::write_file( tmp, bc );
+                brq::rename_if_exists( tmp, cache );
+            }
+            catch ( std::exception & ) {} /* failing to fill the cache is not fatal */
     }
+
+    return bc;
+}
+
+void DiosCC::link_dios_config( std::string n, std::string lamp, std::string cache )
+{
+    if ( cache.empty() && !reuse_runtime )
+        return link_runtime( n, lamp );
+
+    auto bc = prelinked_runtime( n, lamp, cache );
+    auto parsed = llvm::parseBitcodeFile( llvm::MemoryBufferRef( bc, "dios-runtime.bc" ), *context() );
+    if ( !parsed )
+    {
+        /* a damaged cache file: forget it, so that the next call (or run)
+         * prelinks the runtime anew instead of falling back every time */
+        llvm::consumeError( parsed.takeError() );
+        {
+            std::lock_guard< std::mutex > _lock( prelinked_mutex );
+            prelinked.erase( { n, lamp } );
+            if ( !cache.empty() )
+                try { brq::deleteIfExists( cache ); } catch ( std::exception & ) {}
+        }
+        return link_runtime( n, lamp );
+    }
+
+    auto runtime = std::move( parsed.get() );
+
+    /* ODR definitions are equivalent by definition, anything else could
+     * prevent a library member from being linked in */
+    if ( linker->hasModule() )
+        for ( auto &gv : linker->get()->global_values() )
+        {
+            if ( gv.isDeclaration() || gv.hasLocalLinkage() ||
+                 gv.hasLinkOnceODRLinkage() || gv.hasWeakODRLinkage() )
+                continue;
+            if ( auto def = runtime->getNamedValue( gv.getName() ); def && !def->isDeclaration() )
+                return link_runtime( n, lamp );
+        }
+
+    link( std::move( runtime ) );
+    link_dios_libs(); /* members needed by the program but not by the runtime */
 }
 
 void add_dios_header_paths( std::vector< std::string >& paths )
@@ -26,7 +26,23 @@ struct DiosCC : cc::Driver
 
     void setup( Options opts ) { this->opts = opts; }
 
-    void link_dios_config( std::string cfg, std::string lamp = "" );
+    /* Link DiOS in the given configuration (and optionally a LAMP domain)
+     * with the modules linked so far. The part of the runtime which does not
+     * depend on the program (the configuration and everything it needs from
+     * the libraries) is linked only once per process and configuration (and
+     * stored in the file 'cache', if given) and then loaded as a single
+     * module. If the program defines a symbol that is also defined in this
+     * prelinked runtime, the runtime is instead linked from the archives,
+     * since the program might override a library member that way. Since
+     * prelinking costs an extra serialisation and parse, it is only done if
+     * the result can be reused, i.e. with a 'cache' file, or if the process
+     * loads many programs (see 'reuse_runtime'); otherwise this is the same
+     * as link_runtime(). */
+    void link_dios_config( std::string cfg, std::string lamp = "", std::string cache = "" );
+    static std::string prelinked_runtime( std::string cfg, std::string lamp, std::string cache = "" );
+    static inline bool reuse_runtime = false; /* set by long-lived processes (divine serve) */
+    void link_runtime( std::string cfg, std::string lamp );
+    void link_dios_libs();
     void build( cc::ParsedOpts po );
 };
 
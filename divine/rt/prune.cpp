@@ -0,0 +1,206 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <divine/rt/prune.hpp>
+
+DIVINE_RELAX_WARNINGS
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Module.h>
+DIVINE_UNRELAX_WARNINGS
+
+#include <brick-llvm>
+#include <string_view>
+#include <vector>
+
+namespace divine::rt
+{
+
+namespace
+{
+    const std::string_view reserved[] =
+    {
+        "__dios", "__lart", "__lamp", "__sym", "__md_", "__sys_", "__vm_", "__VERIFIER_"
+    };
+
+    const std::set< std::string_view > inserted =
+    {
+        "_start", "__gxx_personality_v0", "_Unwind_Resume", "malloc", "free", "_Exit", "exit", "abort"
+    };
+
+    const std::string root_annos[] =
+    {
+        "divine.link.always", "divine.debugfn", "brick.llvm.prune.root"
+    };
+
+    const std::string_view annotations = "llvm.global.annotations";
+
+    bool is_root( llvm::GlobalValue &gv, const std::set< std::string > &keep )
+    {
+        auto name = gv.getName();
+        std::string_view sv( name.data(), name.size() );
+
+        if ( sv == annotations )
+            return false;
+        if ( sv == "__boot" || sv.substr( 0, 5 ) == "llvm." || inserted.count( sv ) )
+            return true; /* llvm.used, llvm.global_ctors & c. */
+        for ( auto p : reserved )
+            if ( sv.substr( 0, p.size() ) == p )
+                return true;
+        return keep.count( name.str() );
+    }
+}
+
+int prune( llvm::Module &m, const std::set< std::string > &keep )
+{
+    std::set< llvm::GlobalValue * > live;
+    std::set< llvm::Constant * > seen;
+    std::vector< llvm::GlobalValue * > todo;
+    std::vector< llvm::Constant * > stack;
+
+    auto mark = [&]( llvm::GlobalValue *gv )
+    {
+        if ( live.insert( gv ).second )
+            todo.push_back( gv );
+    };
+
+    auto scan = [&]( llvm::Constant *c )
+    {
+        stack.push_back( c );
+        while ( !stack.empty() )
+        {
+            c = stack.back();
+            stack.pop_back();
+            if ( auto gv = llvm::dyn_cast< llvm::GlobalValue >( c ) )
+                mark( gv );
+            else if ( seen.insert( c ).second )
+                for ( auto &op : c->operands() )
+                    if ( auto oc = llvm::dyn_cast< llvm::Constant >( op.get() ) )
+                        stack.push_back( oc );
+        }
+    };
+
+    auto propagate = [&]
+    {
+        while ( !todo.empty() )
+        {
+            auto gv = todo.back();
+            todo.pop_back();
+
+            if ( auto fn = llvm::dyn_cast< llvm::Function >( gv ) )
+            {
+                if ( fn->hasPersonalityFn() )
+                    scan( fn->getPersonalityFn() );
+                for ( auto &bb : *fn )
+                    for ( auto &insn : bb )
+                        for ( auto &op : insn.operands() )
+                            if ( auto c = llvm::dyn_cast< llvm::Constant >( op.get() ) )
+                                scan( c );
+            }
+            else if ( auto var = llvm::dyn_cast< llvm::GlobalVariable >( gv ) )
+            {
+                if ( var->hasInitializer() )
+                    scan( var->getInitializer() );
+            }
+            else if ( auto alias = llvm::dyn_cast< llvm::GlobalAlias >( gv ) )
+                scan( alias->getAliasee() );
+        }
+    };
+
+    for ( auto &gv : m.global_values() )
+        if ( is_root( gv, keep ) )
+            mark( &gv );
+    for ( auto anno : root_annos )
+        brick::llvm::enumerateForAnno< llvm::GlobalValue >( anno, m, mark );
+    propagate();
+
+    /* keep the annotations of live values (and the strings they refer to) */
+    auto annos = m.getNamedGlobal( llvm::StringRef( annotations.data(), annotations.size() ) );
+    auto arr = annos && annos->hasInitializer()
+             ? llvm::dyn_cast< llvm::ConstantArray >( annos->getInitializer() ) : nullptr;
+    if ( arr )
+    {
+        std::vector< llvm::Constant * > entries;
+        for ( auto &op : arr->operands() )
+        {
+            auto entry = llvm::cast< llvm::Constant >( op.get() );
+            auto val = entry->getOperand( 0 )->stripPointerCasts();
+            if ( auto gv = llvm::dyn_cast< llvm::GlobalValue >( val );
+                 gv && !gv->isDeclaration() && !live.count( gv ) )
+                continue;
+            entries.push_back( entry );
+            scan( entry );
+        }
+        propagate();
+
+        if ( entries.size() != arr->getNumOperands() )
+        {
+            auto type = llvm::ArrayType::get( arr->getType()->getElementType(), entries.size() );
+            auto init = llvm::ConstantArray::get( type, entries );
+            auto repl = new llvm::GlobalVariable( m, type, annos->isConstant(), annos->getLinkage(),
+                                                  init, "", annos );
+            repl->setSection( annos->getSection() );
+            repl->takeName( annos );
+            annos->eraseFromParent();
+            annos = repl;
+        }
+        live.insert( annos );
+    }
+
+    std::vector< llvm::Function * > fns;
+    std::vector< llvm::GlobalVariable * > vars;
+    std::vector< llvm::GlobalAlias * > aliases;
+
+    for ( auto &fn : m.functions() )
+        if ( !fn.isDeclaration() && !live.count( &fn ) )
+            fns.push_back( &fn );
+    for ( auto &var : m.globals() )
+        if ( !var.isDeclaration() && !live.count( &var ) )
+            vars.push_back( &var );
+    for ( auto &alias : m.aliases() )
+        if ( !live.count( &alias ) )
+            aliases.push_back( &alias );
+
+    /* drop the references first, since dead values may refer to each other */
+    for ( auto fn : fns )
+        fn->dropAllReferences();
+    for ( auto var : vars )
+        var->setInitializer( nullptr );
+    for ( auto alias : aliases )
+        alias->setAliasee( nullptr );
+
+    auto erase = [&]( llvm::GlobalValue *gv )
+    {
+        gv->removeDeadConstantUsers();
+        if ( !gv->use_empty() ) /* can only be used by other dead values here */
+            gv->replaceAllUsesWith( llvm::UndefValue::get( gv->getType() ) );
+        gv->eraseFromParent();
+    };
+
+    for ( auto fn : fns )
+        erase( fn );
+    for ( auto var : vars )
+        erase( var );
+    for ( auto alias : aliases )
+        erase( alias );
+
+    return fns.size() + vars.size() + aliases.size();
+}
+
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -0,0 +1,51 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <set>
+#include <string>
+
+namespace llvm { class Module; }
+
+namespace divine::rt
+{
+
+/* Remove the functions and global variables of the runtime which the program
+ * cannot reach. Everything referenced (called or otherwise) by a live
+ * function, or by the initialiser of a live variable, is live itself. The
+ * roots are:
+ *
+ *  - the symbols in 'keep' (normally everything the program itself defines),
+ *  - __boot and the entries of llvm.used and the constructor tables,
+ *  - anything annotated as divine.link.always, divine.debugfn or
+ *    brick.llvm.prune.root,
+ *  - symbols in the namespaces that LART and the VM look up by name (__dios,
+ *    __lart, __lamp, __sym, __md, __sys, __vm and __VERIFIER prefixes) along
+ *    with a few other names that LART inserts calls to.
+ *
+ * Since taking the address of a function counts as a reference, indirect
+ * calls are covered as well. Entries of llvm.global.annotations do not keep
+ * anything alive and are dropped along with the values they annotate.
+ * Returns the number of removed definitions. */
+
+int prune( llvm::Module &m, const std::set< std::string > &keep );
+
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
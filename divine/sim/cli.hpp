@@ -92,6 +92,34 @@ struct CLI
 
     Context _ctx;
 
+    /* Execution history for the reverse-* commands. The position counts the
+     * instructions executed (outside of fast-forwarded components) since the
+     * history was last reset. A checkpoint is taken at the start of each
+     * command that executes the program, and then every _checkpoint_interval
+     * instructions; going back means restoring the nearest earlier checkpoint
+     * and replaying (quietly) from there. The checkpoints are copy-on-write
+     * snapshots, so they are cheap, but their number is still bounded: when
+     * there are too many, every other one is dropped and the interval is
+     * doubled. Checkpoints at command boundaries are kept, since a replay must
+     * not span multiple commands (each of which may stop for a different
+     * reason). */
+    struct Checkpoint
+    {
+        int64_t position;
+        bool boundary;
+        Context ctx;
+        Context::RefCnt ref;
+        std::string last;
+        std::pair< int, int > sticky_tid;
+        std::mt19937 rand;
+        bool sched_random;
+        Components ff_components;
+    };
+
+    std::vector< Checkpoint > _checkpoints;
+    int64_t _position = 0, _checkpoint_interval = 1000;
+    static constexpr const size_t _checkpoint_limit = 1024;
+
     using RefLocation = std::pair< llvm::StringRef, int >;
     using Location = std::pair< std::string, int >;
     using Breakpoint = brick::types::Union< vm::CodePointer, Location >;
@@ -175,6 +203,7 @@ struct CLI
         _prompt = strdup( "> " );
         set( "$_", nullDN() );
         update();
+        reset_history();
     }
 
     bool update_lock( vm::CowHeap::Snapshot snap );
@@ -190,6 +219,17 @@ struct CLI
 
     void run( Stepper &step, bool verbose );
     void run( Stepper &step, Stepper::Verbosity verbose );
+
+    /* time travel, implemented in exec.cpp */
+    Checkpoint checkpoint( int64_t position, bool boundary );
+    void progress( int64_t position );
+    void reset_history();
+    void truncate_history();
+    int checkpoint_index( int64_t position );
+    void replay( int index, int64_t target, std::function< void( vm::CodePointer ) > each = nullptr );
+    void seek( int64_t target );
+    int64_t find_back( int count, std::function< bool( vm::CodePointer, vm::CodePointer ) > edge );
+
     Stepper stepper();
     Stepper stepper( command::with_steps s, bool jmp );
     void reach_user();
@@ -210,6 +250,9 @@ struct CLI
     void go( command::stepi s );
     void go( command::stepa s );
     void go( command::rewind re );
+    void go( command::reverse_stepi rs );
+    void go( command::reverse_step rs );
+    void go( command::reverse_continue );
     void go( command::backtrace bt );
     void go( command::show cmd );
     void go( command::tamper );
@@ -148,6 +148,42 @@ namespace divine::sim::command
         rewind() : with_var( "#last" ) {}
     };
 
+    struct with_reverse : base, cast_iron
+    {
+        int count = 1;
+
+        void options( brq::cmd_options &c ) override
+        {
+            base::options( c );
+            c.section( "Reverse Options" );
+            c.opt( "--count", count ) << "go back the given number of steps (default 1)";
+        }
+    };
+
+    struct reverse_stepi : with_reverse
+    {
+        static std::array< std::string, 2 > names()
+        {
+            return { { std::string( "reverse-stepi" ), std::string( "rstepi" ) } };
+        }
+    };
+
+    struct reverse_step : with_reverse
+    {
+        static std::array< std::string, 2 > names()
+        {
+            return { { std::string( "reverse-step" ), std::string( "rstep" ) } };
+        }
+    };
+
+    struct reverse_continue : base, cast_iron
+    {
+        static std::array< std::string, 2 > names()
+        {
+            return { { std::string( "reverse-continue" ), std::string( "rcontinue" ) } };
+        }
+    };
+
     struct show : with_var, teflon
     {
         brq::cmd_flag raw;
@@ -33,6 +33,7 @@ void CLI::go( command::exit )
 void CLI::go( command::start s )
 {
     vm::setup::boot( _ctx );
+    reset_history();
     if ( s.noboot )
         return set( "$_", frameDN() );
 
@@ -43,6 +44,7 @@ void CLI::go( command::start s )
     run( step, s.verbose );
     if ( !_ctx._info.empty() )
         out() << "# boot info:\n" << _ctx._info;
+    reset_history();
     set( "$_", frameDN() );
 }
 
@@ -108,9 +110,49 @@ void CLI::go( command::rewind re )
     if ( update_lock( tgt.snapshot() ) )
         out() << "# rewound to a trace location, locking the scheduler" << std::endl;
     reach_user();
+    reset_history();
     set( "$_", re.var );
 }
 
+void CLI::go( command::reverse_stepi rs )
+{
+    if ( rs.count < 1 )
+        throw brq::error( "the step count must be positive" );
+    if ( rs.count > _position )
+        out() << "# reached the start of the recorded history" << std::endl;
+    seek( std::max< int64_t >( _position - rs.count, 0 ) );
+}
+
+void CLI::go( command::reverse_step rs )
+{
+    if ( rs.count < 1 )
+        throw brq::error( "the step count must be positive" );
+    auto line_start = [&]( vm::CodePointer before, vm::CodePointer at )
+    {
+        return before.null() || location( before ) != location( at );
+    };
+
+    auto target = find_back( rs.count, line_start );
+    if ( target < 0 )
+        out() << "# reached the start of the recorded history" << std::endl;
+    seek( std::max< int64_t >( target, 0 ) );
+}
+
+void CLI::go( command::reverse_continue )
+{
+    auto hit = [&]( vm::CodePointer pc ) { return check_bp( RefLocation( "", 0 ), pc, false ); };
+    auto target = find_back( 1, [&]( vm::CodePointer before, vm::CodePointer at )
+                                {
+                                    return hit( at ) && ( before.null() || !hit( before ) );
+                                } );
+
+    if ( target < 0 )
+        out() << "# no breakpoint was hit, stopped at the start of the recorded history" << std::endl;
+    seek( std::max< int64_t >( target, 0 ) );
+    if ( target >= 0 )
+        hit( _ctx.pc() ); /* print the breakpoint */
+}
+
 void CLI::go( command::backtrace backtrace )
 {
     dbg::DNSet visited;
@@ -36,7 +36,175 @@ void CLI::run( Stepper &step, Stepper::Verbosity verbose )
     if ( !step._breakpoint )
         step._breakpoint = [&]( auto a, auto b ) { return check_bp( initial, a, b ); };
 
+    /* executing from here on replaces whatever history came after this point */
+    truncate_history();
+    if ( _checkpoints.back().position == _position )
+        _checkpoints.pop_back();
+    _checkpoints.push_back( checkpoint( _position, true ) );
+
+    step._progress = [this, start = _position]( Context &, vm::CodePointer, int64_t n )
+    {
+        progress( start + n );
+        return false;
+    };
+
     step.run( _ctx, verbose );
+    _position += step._executed;
+    truncate_history(); /* in case the stepper rewound to a fault */
+}
+
+CLI::Checkpoint CLI::checkpoint( int64_t position, bool boundary )
+{
+    auto snap = _ctx.snapshot();
+    auto last = _dbg.find( "#last" );
+    std::string name;
+
+    if ( last != _dbg.end() && _state_names.count( last->second.snapshot() ) )
+        name = _state_names[ last->second.snapshot() ];
+
+    return Checkpoint{ position, boundary, _ctx, Context::RefCnt( _ctx._refcnt, snap ), name,
+                       _sticky_tid, _rand, _sched_random, _ff_components };
+}
+
+void CLI::progress( int64_t position )
+{
+    if ( position - _checkpoints.back().position < _checkpoint_interval )
+        return;
+
+    _checkpoints.push_back( checkpoint( position, false ) );
+
+    size_t count = 0;
+    for ( auto &cp : _checkpoints )
+        count += !cp.boundary;
+    if ( count <= _checkpoint_limit )
+        return;
+
+    std::vector< Checkpoint > keep;
+    bool odd = false;
+    for ( auto &cp : _checkpoints )
+        if ( cp.boundary || ( odd = !odd ) )
+            keep.push_back( std::move( cp ) );
+    _checkpoints = std::move( keep );
+    _checkpoint_interval *= 2;
+}
+
+void CLI::reset_history()
+{
+    _checkpoints.clear();
+    _position = 0;
+    _checkpoint_interval = 1000;
+    _checkpoints.push_back( checkpoint( 0, true ) );
+}
+
+void CLI::truncate_history()
+{
+    while ( _checkpoints.size() > 1 && _checkpoints.back().position > _position )
+        _checkpoints.pop_back();
+}
+
+int CLI::checkpoint_index( int64_t position )
+{
+    auto i = std::upper_bound( _checkpoints.begin(), _checkpoints.end(), position,
+                               []( int64_t p, const Checkpoint &cp ) { return p < cp.position; } );
+    return int( i - _checkpoints.begin() ) - 1;
+}
+
+void CLI::replay( int index, int64_t target, std::function< void( vm::CodePointer ) > each )
+{
+    auto &cp = _checkpoints[ index ];
+    ASSERT_LEQ( cp.position, target );
+
+    _ctx = cp.ctx;
+    _ctx.flush_ptr2i();
+    _position = cp.position;
+    _sticky_tid = cp.sticky_tid;
+    _rand = cp.rand;
+    if ( !cp.last.empty() )
+        set( "#last", cp.last );
+
+    if ( target == cp.position )
+        return;
+
+    /* replay under the settings that were in effect when this stretch of
+     * history was recorded, without any output */
+    std::ostream null( nullptr );
+    auto stream = _stream;
+    auto fd = out_fd;
+    bool sched_random = _sched_random;
+    _sched_random = cp.sched_random;
+    out( null );
+
+    brick::types::Defer _( [&]
+    {
+        out( *stream, fd );
+        _sched_random = sched_random;
+        _sigint = nullptr;
+    } );
+
+    auto step = stepper();
+    step._ff_components = cp.ff_components;
+    step._breakpoint = []( vm::CodePointer, bool ) { return false; };
+    step._progress = [&]( Context &, vm::CodePointer pc, int64_t n )
+    {
+        if ( cp.position + n == target )
+            return true;
+        if ( each )
+            each( pc );
+        return false;
+    };
+
+    _sigint = &step._sigint;
+    step.run( _ctx, Stepper::Quiet );
+    _ctx._trace.clear();
+    _position = cp.position + step._executed;
+
+    if ( _position != target )
+        brq::raise() << "replay stopped early, at position " << _position << " instead of " << target;
+}
+
+void CLI::seek( int64_t target )
+{
+    replay( checkpoint_index( target ), target );
+    set( "$_", frameDN() );
+}
+
+/* Walk the history backwards from the current position, looking for the
+ * count-th position p such that edge( pc at p - 1, pc at p ) holds; at
+ * position 0, the first argument is a null pointer. Returns -1 if there are
+ * not enough such positions. Leaves the program at an arbitrary earlier
+ * position (the caller is expected to seek). */
+int64_t CLI::find_back( int count, std::function< bool( vm::CodePointer, vm::CodePointer ) > edge )
+{
+    std::ostream null( nullptr );
+    auto stream = _stream;
+    auto fd = out_fd;
+    out( null );
+    brick::types::Defer _( [&] { out( *stream, fd ); } );
+
+    int64_t end = _position;
+    vm::CodePointer at;
+    bool have = false;
+
+    for ( int i = checkpoint_index( end - 1 ); i >= 0; --i )
+    {
+        std::vector< vm::CodePointer > pcs;
+        int64_t start = _checkpoints[ i ].position;
+        replay( i, end, [&]( vm::CodePointer pc ) { pcs.push_back( pc ); } );
+        ASSERT_EQ( int64_t( pcs.size() ), end - start );
+
+        for ( int64_t j = pcs.size() - 1; j >= 0; --j )
+        {
+            if ( have && edge( pcs[ j ], at ) && !--count )
+                return start + j + 1;
+            at = pcs[ j ], have = true;
+        }
+
+        end = start;
+    }
+
+    if ( have && edge( vm::CodePointer(), at ) && !--count )
+        return 0;
+    return -1;
 }
 
 Stepper CLI::stepper()
@@ -314,6 +482,7 @@ void CLI::trace( Trace tr, bool boot, std::function< void() > end )
     _ctx._trace.clear();
 
     end();
+    reset_history();
 }
 
 }
@@ -26,7 +26,8 @@ namespace divine::sim
     {
         brq::cmd_parser p( "", tok );
         using namespace command;
-        return p.parse< exit, start, breakpoint, step, stepi, stepa, rewind, backtrace,
+        return p.parse< exit, start, breakpoint, step, stepi, stepa, rewind,
+                        reverse_step, reverse_stepi, reverse_continue, backtrace,
                         show, diff, dot, inspect, tamper, call, info,
                         up, down, set, thread, bitcode, source, setup >();
     }
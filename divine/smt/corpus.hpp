@@ -0,0 +1,223 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <brick-smt>
+#include <brick-except>
+#include <brick-assert>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+/* A corpus is a flat binary file of solver queries, as they were handed over
+ * to the solver during a verification run. After an 8-byte magic, each record
+ * consists of a fixed header (kind, result, number of formulas, time taken in
+ * nanoseconds) followed by the formulas, each prefixed by its length. All
+ * integers are stored in host byte order. For equality (and subsumption)
+ * queries, formulas alternate between the two heaps: path conditions first,
+ * then the pairs of compared values. */
+
+namespace divine::smt::corpus
+{
+    using expr_t = brq::smt_expr< std::vector >;
+    using clock = std::chrono::steady_clock;
+
+    enum class Kind : uint8_t { Feasible, Equal, Subsumes };
+    static constexpr int kinds = int( Kind::Subsumes ) + 1;
+
+    struct Query
+    {
+        Kind kind = Kind::Feasible;
+        uint8_t result = 0; /* a solver::Result */
+        uint64_t nanos = 0;
+        std::vector< expr_t > exprs;
+    };
+
+    static constexpr char magic[ 8 ] = { 'D', 'I', 'V', 'S', 'M', 'T', 0, 1 };
+
+    template< typename T >
+    void put( std::ostream &o, T v ) { o.write( reinterpret_cast< const char * >( &v ), sizeof( v ) ); }
+
+    template< typename T >
+    bool get( std::istream &i, T &v ) { return bool( i.read( reinterpret_cast< char * >( &v ), sizeof( v ) ) ); }
+
+    struct Writer
+    {
+        std::unique_ptr< std::ostream > _owned;
+        std::ostream &_out;
+        std::mutex _mutex;
+
+        Writer( std::ostream &o ) : _out( o ) { _out.write( magic, sizeof( magic ) ); }
+        Writer( std::string path )
+            : _owned( new std::ofstream( path, std::ios::binary ) ), _out( *_owned )
+        {
+            if ( !_out )
+                brq::raise() << "could not open " << path << " for writing";
+            _out.write( magic, sizeof( magic ) );
+        }
+
+        void write( const Query &q )
+        {
+            std::lock_guard< std::mutex > _lock( _mutex );
+            put( _out, q.kind );
+            put( _out, q.result );
+            put( _out, uint16_t( q.exprs.size() ) );
+            put( _out, q.nanos );
+            for ( auto &e : q.exprs )
+            {
+                put( _out, uint32_t( e.size() ) );
+                _out.write( reinterpret_cast< const char * >( e.data() ), e.size() );
+            }
+            _out.flush();
+        }
+    };
+
+    struct Reader
+    {
+        std::unique_ptr< std::istream > _owned;
+        std::istream &_in;
+
+        Reader( std::istream &i ) : _in( i ) { check(); }
+        Reader( std::string path )
+            : _owned( new std::ifstream( path, std::ios::binary ) ), _in( *_owned )
+        {
+            if ( !_in )
+                brq::raise() << "could not open " << path;
+            check();
+        }
+
+        void check()
+        {
+            char m[ sizeof( magic ) ];
+            if ( !_in.read( m, sizeof( m ) ) || !std::equal( m, m + sizeof( m ), magic ) )
+                brq::raise() << "not a query corpus (bad magic)";
+        }
+
+        bool read( Query &q )
+        {
+            uint16_t count;
+            if ( !get( _in, q.kind ) )
+                return false;
+            if ( !get( _in, q.result ) || !get( _in, count ) || !get( _in, q.nanos ) )
+                brq::raise() << "truncated query corpus";
+            if ( int( q.kind ) >= kinds )
+                brq::raise() << "bad query kind " << int( q.kind ) << " in the corpus";
+
+            q.exprs.resize( count );
+            for ( auto &e : q.exprs )
+            {
+                uint32_t size;
+                if ( !get( _in, size ) )
+                    brq::raise() << "truncated query corpus";
+                e.resize( size );
+                if ( !_in.read( reinterpret_cast< char * >( e.data() ), size ) )
+                    brq::raise() << "truncated query corpus";
+            }
+
+            return true;
+        }
+
+        std::vector< Query > load()
+        {
+            std::vector< Query > rv;
+            for ( Query q; read( q ); )
+                rv.push_back( std::move( q ) );
+            return rv;
+        }
+    };
+
+    /* the process-wide recorder, active when set */
+    inline std::unique_ptr< Writer > &recorder()
+    {
+        static std::unique_ptr< Writer > w;
+        return w;
+    }
+
+    inline void open( std::string path ) { recorder().reset( new Writer( path ) ); }
+
+    template< typename solve_t >
+    auto record( Kind kind, std::vector< expr_t > exprs, solve_t solve )
+    {
+        auto start = clock::now();
+        auto result = solve();
+        auto time = std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - start );
+        recorder()->write( Query{ kind, uint8_t( result ), uint64_t( time.count() ), std::move( exprs ) } );
+        return result;
+    }
+}
+
+namespace divine::t_smt
+{
+    struct corpus
+    {
+        using expr_t = smt::corpus::expr_t;
+        using op = brq::smt_op;
+
+        TEST( roundtrip )
+        {
+            std::stringstream buf;
+            smt::corpus::Writer w( buf );
+
+            expr_t e;
+            e.apply( brq::smt_atom_t< brq::smt_varid_t >( op::var_i32, 3 ) );
+            e.apply( brq::smt_atom_t< uint32_t >( op::const_i32, 7 ) );
+            e.apply( op::bv_ult );
+
+            w.write( { smt::corpus::Kind::Feasible, 1, 1234, { e } } );
+            w.write( { smt::corpus::Kind::Equal, 0, 99, { expr_t(), e, e, e } } );
+
+            smt::corpus::Reader r( buf );
+            auto qs = r.load();
+            ASSERT_EQ( qs.size(), 2 );
+            ASSERT( qs[ 0 ].kind == smt::corpus::Kind::Feasible );
+            ASSERT_EQ( qs[ 0 ].nanos, 1234 );
+            ASSERT( qs[ 0 ].exprs[ 0 ] == e );
+            ASSERT( qs[ 1 ].kind == smt::corpus::Kind::Equal );
+            ASSERT_EQ( qs[ 1 ].exprs.size(), 4 );
+            ASSERT( qs[ 1 ].exprs[ 0 ].empty() );
+            ASSERT( qs[ 1 ].exprs[ 3 ] == e );
+        }
+
+        TEST( bad_magic )
+        {
+            std::stringstream buf( "garbage!" );
+            bool caught = false;
+            try { smt::corpus::Reader r( buf ); } catch ( brq::error & ) { caught = true; }
+            ASSERT( caught );
+        }
+
+        TEST( bad_kind )
+        {
+            std::stringstream buf;
+            smt::corpus::Writer w( buf );
+            w.write( { smt::corpus::Kind( 7 ), 0, 0, {} } );
+
+            smt::corpus::Reader r( buf );
+            bool caught = false;
+            try { r.load(); } catch ( brq::error & ) { caught = true; }
+            ASSERT( caught );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
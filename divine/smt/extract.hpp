@@ -26,6 +26,30 @@
 namespace divine::smt
 {
 
+/* call f on each (non-empty) clause of the path condition stored at ptr */
+template< typename heap_t, typename F >
+void each_clause( heap_t &heap, vm::HeapPointer ptr, F f )
+{
+    using expr_t = brq::smt_expr< std::vector >;
+    vm::PointerV map( ptr ), clause;
+
+    if ( !heap.valid( ptr ) )
+        return;
+
+    for ( int i = 0; i < heap.size( ptr ); i += vm::PointerBytes )
+    {
+        heap.read_shift( map, clause );
+        if ( clause.pointer() && heap.valid( clause.cooked() ) )
+        {
+            ASSERT_EQ( clause.cooked().type(), vm::PointerType::Marked );
+            auto b = heap.unsafe_bytes( clause.cooked() );
+            expr_t clause_expr{ b.begin(), b.end() - 1 };
+            if ( !clause_expr.empty() )
+                f( clause_expr );
+        }
+    }
+}
+
 template< typename Builder >
 struct Extract : Builder
 {
@@ -45,32 +69,18 @@ struct Extract : Builder
 
     expr_t read_constraints( vm::HeapPointer ptr )
     {
-        vm::PointerV map( ptr ), clause;
         expr_t expr;
-
-        if ( !_heap.valid( ptr ) )
-            return expr;
-
         bool first = true;
 
-        for ( int i = 0; i < _heap.size( ptr ); i += vm::PointerBytes )
+        each_clause( _heap, ptr, [&]( const expr_t &clause_expr )
         {
-            _heap.read_shift( map, clause );
-            if ( clause.pointer() && _heap.valid( clause.cooked() ) )
-            {
-                ASSERT_EQ( clause.cooked().type(), vm::PointerType::Marked );
-                auto b = _heap.unsafe_bytes( clause.cooked() );
-                expr_t clause_expr{ b.begin(), b.end() - 1 };
-                TRACE( "clause:", clause_expr, first );
-                if ( clause_expr.empty() )
-                    continue;
-                expr.apply( clause_expr );
-                if ( first )
-                    first = false;
-                else
-                    expr.apply( brq::smt_op::bool_and );
-            }
-        }
+            TRACE( "clause:", clause_expr, first );
+            expr.apply( clause_expr );
+            if ( first )
+                first = false;
+            else
+                expr.apply( brq::smt_op::bool_and );
+        } );
 
         TRACE( "constraints:", expr );
         return expr;
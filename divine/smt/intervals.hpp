@@ -0,0 +1,435 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/smt/simplify.hpp>
+#include <brick-interval>
+
+namespace divine::smt
+{
+    /* An abstract interpretation of a simplified formula in the domain of
+     * (unsigned) intervals, used as a prefilter in front of the solver.
+     * Unlike Simplify::decide, which only looks at conjuncts of the form
+     * (x op c), this propagates bounds through the arithmetic: each round
+     * first evaluates all terms bottom-up and then pushes the requirement
+     * that the formula is true back down towards the variables, narrowing
+     * their ranges. Once the ranges stabilise (or after a fixed number of
+     * rounds), an empty range anywhere means the path is infeasible. If
+     * nothing conflicts, the bounds of the final ranges are tried as
+     * candidate models, and a successful one proves feasibility.
+     *
+     * Values wider than 62 bits do not fit into the bounds (whose extremes
+     * stand for infinities) and are left unconstrained, as are floats,
+     * arrays and anything else we do not understand. */
+
+    struct Intervals
+    {
+        using op_t = brq::smt_op;
+        using bound = brq::bound< int64_t >;
+        using ival = brq::interval< bound >;
+
+        static constexpr int max_rounds = 16;
+
+        const Simplify &_s;
+        std::vector< bool > _live;
+        std::vector< ival > _val, _req;
+
+        explicit Intervals( const Simplify &s ) : _s( s ) {}
+
+        static uint64_t mask( int bw ) { return Simplify::mask( bw ); }
+        static int64_t smax( int bw ) { return int64_t( mask( bw - 1 ) ); }
+
+        op_t op( int t ) const { return _s.op( t ); }
+        int bw( int t ) const { return _s.bw( t ); }
+        int arg( int t, int n ) const { return _s.arg( t, n ); }
+
+        bool tracked( int t ) const { return _s.is_bv( t ) && !_s.is_float( t ) && bw( t ) <= 62; }
+        static ival range( bound lo, bound hi ) { return ival( lo, hi ); }
+        ival top( int t ) const { return tracked( t ) ? range( 0, int64_t( mask( bw( t ) ) ) ) : ival(); }
+        ival point( int64_t v ) const { return range( v, v ); }
+        ival boolean( brq::tristate t ) const { return brq::maybe( t ) ? range( 0, 1 ) : point( bool( t ) ); }
+
+        /* the same set of values, seen as signed numbers */
+        ival as_signed( ival i, int bw ) const
+        {
+            int64_t wrap = int64_t( mask( bw ) ) + 1;
+            if ( i.high._value <= smax( bw ) )
+                return i;
+            if ( i.low._value > smax( bw ) )
+                return range( i.low._value - wrap, i.high._value - wrap );
+            return range( -smax( bw ) - 1, smax( bw ) );
+        }
+
+        brq::tristate equal( ival a, ival b ) const
+        {
+            if ( a.constant() && b.constant() )
+                return brq::tristate( a.low == b.low );
+            return a.intersects( b ) ? brq::tristate( brq::maybe ) : brq::tristate( false );
+        }
+
+        brq::tristate compare( op_t o, ival a, ival b, int bw ) const
+        {
+            if ( Simplify::is_signed( o ) )
+                a = as_signed( a, bw ), b = as_signed( b, bw );
+
+            switch ( o )
+            {
+                case op_t::eq:  return equal( a, b );
+                case op_t::neq: return !equal( a, b );
+                case op_t::bv_ult: case op_t::bv_slt: return a < b;
+                case op_t::bv_ule: case op_t::bv_sle: return a <= b;
+                case op_t::bv_ugt: case op_t::bv_sgt: return a > b;
+                case op_t::bv_uge: case op_t::bv_sge: return a >= b;
+                default: return brq::maybe;
+            }
+        }
+
+        /* results outside of [0, 2^bw) are either shifted back if the whole
+         * interval wrapped around, or widened to the entire range */
+        ival wrap( ival i, int t ) const
+        {
+            int64_t m = mask( bw( t ) ), w = m + 1;
+            if ( i.low._value >= 0 && i.high._value <= m )
+                return i;
+            if ( i.high._value < 0 && i.low._value >= -w )
+                return range( i.low + w, i.high + w );
+            if ( i.low._value > m && i.high._value <= 2 * m + 1 )
+                return range( i.low - w, i.high - w );
+            return top( t );
+        }
+
+        ival forward( int t ) const
+        {
+            auto o = op( t );
+
+            if ( !tracked( t ) )
+                return ival();
+            if ( _s.is_const( t ) )
+                return point( _s.val( t ) );
+            if ( Simplify::is_var_op( o ) )
+                return _val[ t ];
+
+            auto traits = brq::smt_traits( o );
+            int a = arg( t, 0 ), b = traits.arity >= 2 ? arg( t, 1 ) : -1;
+            if ( !tracked( a ) || ( b >= 0 && !tracked( b ) ) )
+                return top( t );
+
+            ival x = _val[ a ], y = b >= 0 ? _val[ b ] : ival();
+
+            if ( traits.type == brq::smt_op_compare && !traits.floating )
+                return boolean( compare( o, x, y, bw( a ) ) );
+
+            switch ( o )
+            {
+                case op_t::bool_not:
+                case op_t::bv_not:
+                    return bw( t ) == 1 ? range( 1 - x.high._value, 1 - x.low._value )
+                                        : range( int64_t( mask( bw( t ) ) ) - x.high._value,
+                                                int64_t( mask( bw( t ) ) ) - x.low._value );
+                case op_t::bool_and:
+                    return boolean( brq::tristate( x ) && brq::tristate( y ) );
+                case op_t::bool_or:
+                    return boolean( brq::tristate( x ) || brq::tristate( y ) );
+                case op_t::bv_add: return wrap( x + y, t );
+                case op_t::bv_sub: return wrap( x - y, t );
+                case op_t::bv_mul: return wrap( x * y, t );
+                case op_t::bv_udiv:
+                    if ( y.low._value > 0 )
+                        return range( x.low / y.high, x.high / y.low );
+                    return top( t );
+                case op_t::bv_urem:
+                    if ( y.low._value > 0 )
+                        return range( 0, std::min( x.high, y.high - 1 ) );
+                    return range( 0, x.high );
+                case op_t::bv_and:
+                    if ( bw( t ) == 1 )
+                        return boolean( brq::tristate( x ) && brq::tristate( y ) );
+                    return range( 0, std::min( x.high, y.high ) );
+                case op_t::bv_or:
+                    if ( bw( t ) == 1 )
+                        return boolean( brq::tristate( x ) || brq::tristate( y ) );
+                    return range( std::max( x.low, y.low ),
+                                 std::min( x.high + y.high, bound( mask( bw( t ) ) ) ) );
+                case op_t::bv_lshr:
+                    if ( y.high._value < bw( t ) )
+                        return range( x.low._value >> y.high._value, x.high._value >> y.low._value );
+                    return range( 0, x.high );
+                case op_t::bv_zext:
+                    return x;
+                case op_t::bv_trunc:
+                    return x.high._value <= int64_t( mask( bw( t ) ) ) ? x : top( t );
+                case op_t::bv_sext:
+                    if ( x.high._value <= smax( bw( a ) ) )
+                        return x;
+                    if ( x.low._value > smax( bw( a ) ) )
+                        return range( x.low + int64_t( mask( bw( t ) ) - mask( bw( a ) ) ),
+                                     x.high + int64_t( mask( bw( t ) ) - mask( bw( a ) ) ) );
+                    return top( t );
+                case op_t::bv_extract:
+                    if ( ( _s.val( t ) & 0xff ) == 0 && x.high._value <= int64_t( mask( bw( t ) ) ) )
+                        return x;
+                    return top( t );
+                default:
+                    return top( t );
+            }
+        }
+
+        /* narrow the requirement on a subterm; false means a conflict */
+        bool require( int t, ival i )
+        {
+            if ( !tracked( t ) )
+                return true;
+            _req[ t ] = meet( _req[ t ], i );
+            return !_req[ t ].empty() && _val[ t ].intersects( _req[ t ] );
+        }
+
+        /* given that term t only takes the values in v, narrow its arguments */
+        bool backward( int t, ival v )
+        {
+            auto o = op( t );
+            auto traits = brq::smt_traits( o );
+            if ( traits.arity == 0 || traits.floating )
+                return true;
+
+            int a = arg( t, 0 ), b = traits.arity >= 2 ? arg( t, 1 ) : -1;
+            if ( !tracked( a ) || ( b >= 0 && !tracked( b ) ) )
+                return true;
+            ival x = _val[ a ], y = b >= 0 ? _val[ b ] : ival();
+            int64_t m = mask( bw( a ) );
+
+            if ( traits.type == brq::smt_op_compare )
+            {
+                if ( !v.constant() )
+                    return true;
+                if ( v.low == 0 )
+                    o = Simplify::negate( o );
+                if ( Simplify::is_signed( o ) )
+                {
+                    if ( x.high._value > smax( bw( a ) ) || y.high._value > smax( bw( a ) ) )
+                        return true; /* too hard, unless both are non-negative */
+                }
+
+                switch ( o )
+                {
+                    case op_t::eq:
+                        return require( a, y ) && require( b, x );
+                    case op_t::neq:
+                        if ( y.constant() && x.low == y.low )
+                            return require( a, range( x.low + 1, x.high ) );
+                        if ( y.constant() && x.high == y.low )
+                            return require( a, range( x.low, x.high - 1 ) );
+                        if ( x.constant() && y.low == x.low )
+                            return require( b, range( y.low + 1, y.high ) );
+                        if ( x.constant() && y.high == x.low )
+                            return require( b, range( y.low, y.high - 1 ) );
+                        return true;
+                    case op_t::bv_ult: case op_t::bv_slt:
+                        return require( a, range( 0, y.high - 1 ) ) && require( b, range( x.low + 1, m ) );
+                    case op_t::bv_ule: case op_t::bv_sle:
+                        return require( a, range( 0, y.high ) ) && require( b, range( x.low, m ) );
+                    case op_t::bv_ugt: case op_t::bv_sgt:
+                        return require( a, range( y.low + 1, m ) ) && require( b, range( 0, x.high - 1 ) );
+                    case op_t::bv_uge: case op_t::bv_sge:
+                        return require( a, range( y.low, m ) ) && require( b, range( 0, x.high ) );
+                    default:
+                        return true;
+                }
+            }
+
+            switch ( o )
+            {
+                case op_t::bool_not:
+                    return require( a, range( 1 - v.high._value, 1 - v.low._value ) );
+                case op_t::bool_and:
+                case op_t::bv_and:
+                    if ( bw( t ) == 1 && v.low == 1 )
+                        return require( a, point( 1 ) ) && require( b, point( 1 ) );
+                    return true;
+                case op_t::bool_or:
+                case op_t::bv_or:
+                    if ( bw( t ) == 1 && v.high == 0 )
+                        return require( a, point( 0 ) ) && require( b, point( 0 ) );
+                    return true;
+                case op_t::bv_add:
+                    if ( ( x.high + y.high )._value > int64_t( mask( bw( t ) ) ) )
+                        return true; /* may wrap around */
+                    return require( a, v - y ) && require( b, v - x );
+                case op_t::bv_sub:
+                    if ( ( x.low - y.high )._value < 0 )
+                        return true;
+                    return require( a, v + y ) && require( b, x - v );
+                case op_t::bv_zext:
+                    return require( a, v );
+                case op_t::bv_extract:
+                    if ( ( _s.val( t ) & 0xff ) != 0 )
+                        return true; /* the result does not determine the low bits */
+                    [[fallthrough]];
+                case op_t::bv_trunc:
+                    /* only if no bits were cut off, i.e. the result equals the operand */
+                    if ( x.high._value <= int64_t( mask( bw( t ) ) ) )
+                        return require( a, v );
+                    return true;
+                case op_t::bv_sext:
+                    if ( x.high._value <= smax( bw( a ) ) )
+                        return require( a, v );
+                    return true;
+                default:
+                    return true;
+            }
+        }
+
+        void mark_live()
+        {
+            _live.assign( _s._terms.size(), false );
+            std::vector< int > work{ _s._root };
+            while ( !work.empty() )
+            {
+                int t = work.back();
+                work.pop_back();
+                if ( _live[ t ] )
+                    continue;
+                _live[ t ] = true;
+                for ( int i = 0; i < Simplify::arity( op( t ) ); ++i )
+                    work.push_back( arg( t, i ) );
+            }
+        }
+
+        /* one round of propagation; returns false on a conflict and sets
+         * changed if some variable was narrowed */
+        bool round( bool &changed )
+        {
+            int n = _s._terms.size();
+
+            /* arguments are always created before the terms that use them,
+             * hence index order is a topological order of the term graph */
+            for ( int t = 0; t < n; ++t )
+                if ( _live[ t ] && !Simplify::is_var_op( op( t ) ) )
+                    _val[ t ] = forward( t );
+
+            for ( int t = 0; t < n; ++t )
+                _req[ t ] = top( t );
+            _req[ _s._root ] = point( 1 );
+
+            for ( int t = n - 1; t >= 0; --t )
+            {
+                if ( !_live[ t ] || !tracked( t ) )
+                    continue;
+
+                auto v = meet( _val[ t ], _req[ t ] );
+                if ( v.empty() )
+                    return false;
+
+                if ( Simplify::is_var_op( op( t ) ) )
+                {
+                    if ( v.low != _val[ t ].low || v.high != _val[ t ].high )
+                        _val[ t ] = v, changed = true;
+                }
+                else if ( !backward( t, v ) )
+                    return false;
+            }
+
+            return true;
+        }
+
+        /* evaluate the formula with each variable set to the lower (upper)
+         * bound of its range */
+        bool evaluate( bool upper, uint64_t &result ) const
+        {
+            int n = _s._terms.size();
+            std::vector< uint64_t > v( n );
+
+            for ( int t = 0; t < n; ++t )
+            {
+                if ( !_live[ t ] )
+                    continue;
+
+                auto o = op( t );
+                auto arg_v = [&]( int i ) { return v[ arg( t, i ) ]; };
+                int tbw = bw( t );
+
+                if ( _s.is_float( t ) || !_s.is_bv( t ) )
+                    return false;
+                if ( _s.is_const( t ) )
+                    v[ t ] = _s.val( t );
+                else if ( Simplify::is_var_op( o ) )
+                    v[ t ] = tracked( t ) ? uint64_t( upper ? _val[ t ].high._value : _val[ t ].low._value ) : 0;
+                else if ( brq::smt_traits( o ).type == brq::smt_op_compare )
+                {
+                    if ( Simplify::negate( o ) == op_t::invalid || _s.is_float( arg( t, 0 ) ) )
+                        return false;
+                    v[ t ] = Simplify::compare( o, arg_v( 0 ), arg_v( 1 ), bw( arg( t, 0 ) ) );
+                }
+                else switch ( o )
+                {
+                    case op_t::bool_not: v[ t ] = !arg_v( 0 ); break;
+                    case op_t::bool_and: v[ t ] = arg_v( 0 ) && arg_v( 1 ); break;
+                    case op_t::bool_or:  v[ t ] = arg_v( 0 ) || arg_v( 1 ); break;
+                    case op_t::bool_xor: v[ t ] = bool( arg_v( 0 ) ) != bool( arg_v( 1 ) ); break;
+                    case op_t::bv_not:   v[ t ] = ~arg_v( 0 ) & mask( tbw ); break;
+                    case op_t::bv_neg:   v[ t ] = -arg_v( 0 ) & mask( tbw ); break;
+                    case op_t::bv_zext:  v[ t ] = arg_v( 0 ); break;
+                    case op_t::bv_trunc: v[ t ] = arg_v( 0 ) & mask( tbw ); break;
+                    case op_t::bv_sext:
+                        v[ t ] = uint64_t( Simplify::sext( arg_v( 0 ), bw( arg( t, 0 ) ) ) ) & mask( tbw );
+                        break;
+                    case op_t::bv_extract:
+                        v[ t ] = ( arg_v( 0 ) >> ( _s.val( t ) & 0xff ) ) & mask( tbw ); break;
+                    case op_t::bv_concat:
+                        v[ t ] = ( arg_v( 0 ) << bw( arg( t, 1 ) ) | arg_v( 1 ) ) & mask( tbw ); break;
+                    default:
+                        if ( brq::smt_traits( o ).arity != 2 || o < op_t::bv_and || o > op_t::bv_ashr )
+                            return false;
+                        if ( !Simplify::fold( o, arg_v( 0 ), arg_v( 1 ), tbw, v[ t ] ) )
+                            return false; /* division by zero */
+                }
+            }
+
+            result = v[ _s._root ];
+            return true;
+        }
+
+        brq::tristate decide()
+        {
+            if ( _s._root < 0 || !tracked( _s._root ) )
+                return brq::maybe;
+            if ( _s.constant() )
+                return brq::tristate( _s.value() );
+
+            int n = _s._terms.size();
+            mark_live();
+            _val.resize( n );
+            _req.resize( n );
+            for ( int t = 0; t < n; ++t )
+                _val[ t ] = top( t );
+
+            bool changed = true;
+            for ( int i = 0; changed && i < max_rounds; ++i )
+                if ( changed = false; !round( changed ) )
+                    return brq::tristate( false );
+
+            for ( bool upper : { false, true } )
+                if ( uint64_t r; evaluate( upper, r ) && r )
+                    return brq::tristate( true );
+
+            return brq::maybe;
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -0,0 +1,797 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <brick-smt>
+#include <brick-tristate>
+#include <brick-assert>
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+namespace divine::smt
+{
+    /* A local rewriting pass over RPN formulas, applied before a formula is
+     * handed over to a solver builder. The expression is parsed into a
+     * hash-consed term graph and each new node is first offered to the
+     * rewrite rules (constant folding, resize chains, extract/concat
+     * cleanup, comparison narrowing and a few algebraic identities). The
+     * result is emitted back in RPN form.
+     *
+     * Additionally, decide() looks at the top-level conjunction of the
+     * simplified formula: when every conjunct only bounds a single variable
+     * by a constant, per-variable intervals settle satisfiability without
+     * involving a solver at all. */
+
+    struct Simplify
+    {
+        using op_t = brq::smt_op;
+        using expr_t = brq::smt_expr< std::vector >;
+
+        struct Term
+        {
+            op_t op;
+            int bw;
+            uint64_t imm = 0;
+            int arg[ 3 ] = { -1, -1, -1 };
+
+            bool operator==( const Term &o ) const
+            {
+                return op == o.op && imm == o.imm && bw == o.bw &&
+                       std::equal( arg, arg + 3, o.arg );
+            }
+        };
+
+        struct TermHash
+        {
+            size_t operator()( const Term &t ) const
+            {
+                uint64_t h = uint64_t( t.op ) * 0x9e3779b97f4a7c15ull ^ t.imm;
+                for ( int a : t.arg )
+                    h = ( h ^ uint64_t( a ) ) * 0x100000001b3ull;
+                return h ^ ( h >> 29 );
+            }
+        };
+
+        std::vector< Term > _terms;
+        std::unordered_map< Term, int, TermHash > _index;
+        int _root = -1;
+
+        /* simplify an expression; returns the input unchanged if it contains
+         * something the parser does not understand */
+        expr_t run( const expr_t &expr )
+        {
+            _terms.clear();
+            _index.clear();
+            _root = -1;
+
+            if ( !parse( expr ) )
+                return _root = -1, expr;
+
+            expr_t out;
+            emit( out, _root );
+            return out;
+        }
+
+        /* the top-level conjuncts of the simplified formula, in RPN form */
+        std::vector< expr_t > conjuncts() const
+        {
+            std::vector< expr_t > rv;
+            std::vector< int > work;
+
+            if ( _root >= 0 )
+                work.push_back( _root );
+
+            while ( !work.empty() )
+            {
+                int c = work.back();
+                work.pop_back();
+
+                auto o = op( c );
+                if ( o == op_t::bool_and || ( o == op_t::bv_and && bw( c ) == 1 ) )
+                    work.push_back( arg( c, 1 ) ), work.push_back( arg( c, 0 ) );
+                else
+                    emit( rv.emplace_back(), c );
+            }
+
+            return rv;
+        }
+
+        /* constant formulas are decided trivially, the rest is up to decide() */
+        bool constant() const { return _root >= 0 && is_const( _root ); }
+        bool value() const { return val( _root ); }
+
+        static bool is_const_op( op_t op ) { return op >= op_t::const_i1 && op <= op_t::const_i64; }
+        static bool is_var_op( op_t op ) { return op >= op_t::var_i1 && op <= op_t::var_i64; }
+
+        static bool representable( int bw )
+        {
+            return bw == 1 || bw == 8 || bw == 16 || bw == 32 || bw == 64;
+        }
+
+        static uint64_t mask( int bw ) { return bw >= 64 ? ~0ull : ( 1ull << bw ) - 1; }
+
+        static int64_t sext( uint64_t v, int bw )
+        {
+            return bw >= 64 ? int64_t( v ) : int64_t( v << ( 64 - bw ) ) >> ( 64 - bw );
+        }
+
+        static op_t const_op( int bw )
+        {
+            switch ( bw )
+            {
+                case  1: return op_t::const_i1;
+                case  8: return op_t::const_i8;
+                case 16: return op_t::const_i16;
+                case 32: return op_t::const_i32;
+                case 64: return op_t::const_i64;
+                default: UNREACHABLE( "no constant of width", bw );
+            }
+        }
+
+        static int arity( op_t op )
+        {
+            if ( op == op_t::load )  return 2;
+            if ( op == op_t::store ) return 3;
+            return brq::smt_arity( op );
+        }
+
+        const Term &term( int i ) const { return _terms[ i ]; }
+        op_t op( int i ) const { return _terms[ i ].op; }
+        int bw( int i ) const { return _terms[ i ].bw; }
+        int arg( int i, int n ) const { return _terms[ i ].arg[ n ]; }
+        bool is_const( int i ) const { return is_const_op( op( i ) ); }
+        uint64_t val( int i ) const { return _terms[ i ].imm; }
+        int64_t sval( int i ) const { return sext( val( i ), bw( i ) ); }
+
+        bool is_float( int i ) const
+        {
+            auto t = brq::smt_traits( op( i ) );
+            if ( op( i ) == op_t::load )
+                return is_float( arg( i, 0 ) );
+            if ( op( i ) == op_t::array )
+            {
+                brq::smt_array_type at;
+                std::memcpy( &at, &_terms[ i ].imm, sizeof( at ) );
+                return at.type == brq::smt_array_type::type_t::floating;
+            }
+            return t.floating && t.type != brq::smt_op_compare;
+        }
+
+        /* an integral bit-vector which we can reason about */
+        bool is_bv( int i ) const
+        {
+            auto o = op( i );
+            return !is_float( i ) && o != op_t::array && o != op_t::store && bw( i ) <= 64;
+        }
+
+        bool is_bool( int i ) const
+        {
+            auto t = brq::smt_traits( op( i ) );
+            return bw( i ) == 1 && ( t.type == brq::smt_op_compare || t.type == brq::smt_op_bool );
+        }
+
+        int intern( const Term &t )
+        {
+            auto [ it, fresh ] = _index.emplace( t, int( _terms.size() ) );
+            if ( fresh )
+                _terms.push_back( t );
+            return it->second;
+        }
+
+        int mk( Term t )
+        {
+            int r = rewrite( t );
+            return r >= 0 ? r : intern( t );
+        }
+
+        int mk( op_t o, int bw, uint64_t imm, int a = -1, int b = -1, int c = -1 )
+        {
+            Term t{ o, bw, imm };
+            t.arg[ 0 ] = a, t.arg[ 1 ] = b, t.arg[ 2 ] = c;
+            return mk( t );
+        }
+
+        int mk_const( uint64_t v, int bw ) { return intern( Term{ const_op( bw ), bw, v & mask( bw ) } ); }
+        int mk_bool( bool v ) { return mk_const( v, 1 ); }
+        int mk_extract( int x, int lo, int hi )
+        {
+            return mk( op_t::bv_extract, hi - lo + 1, uint64_t( lo ) | uint64_t( hi ) << 8, x );
+        }
+
+        bool parse( const expr_t &expr )
+        {
+            std::vector< int > stack;
+
+            for ( auto &atom : expr )
+            {
+                auto o = atom.op;
+                if ( atom.is_cast() || o == op_t::invalid )
+                    return false;
+
+                Term t{ o, 0 };
+                auto imm = reinterpret_cast< const uint8_t * >( &atom ) + 1;
+                std::memcpy( &t.imm, imm, atom.imm_size() );
+
+                int n = arity( o );
+                if ( int( stack.size() ) < n )
+                    return false;
+                for ( int i = 0; i < n; ++i )
+                    t.arg[ i ] = stack[ stack.size() - n + i ];
+                stack.resize( stack.size() - n );
+
+                if ( o == op_t::load || o == op_t::store )
+                    t.bw = atom.bw( bw( t.arg[ 0 ] ) );
+                else if ( n == 0 )
+                    t.bw = atom.bw();
+                else if ( n == 1 )
+                    t.bw = atom.bw( bw( t.arg[ 0 ] ) );
+                else if ( o == op_t::bv_concat || brq::smt_bw( o ) )
+                    t.bw = atom.bw( bw( t.arg[ 0 ] ), bw( t.arg[ 1 ] ) );
+                else
+                    t.bw = bw( t.arg[ 0 ] );
+
+                if ( t.op == op_t::bv_zfit )
+                    t.op = t.bw > bw( t.arg[ 0 ] ) ? op_t::bv_zext : op_t::bv_trunc;
+
+                if ( is_const_op( o ) )
+                    t.imm &= mask( t.bw );
+
+                stack.push_back( mk( t ) );
+            }
+
+            if ( stack.size() != 1 )
+                return false;
+
+            _root = stack.back();
+            return true;
+        }
+
+        void emit( expr_t &out, int root ) const
+        {
+            std::vector< std::pair< int, int > > stack{ { root, 0 } };
+
+            while ( !stack.empty() )
+            {
+                auto [ i, next ] = stack.back();
+                auto &t = _terms[ i ];
+
+                if ( next < arity( t.op ) )
+                {
+                    ++ stack.back().second;
+                    stack.emplace_back( t.arg[ next ], 0 );
+                    continue;
+                }
+
+                stack.pop_back();
+                out.apply( t.op );
+                auto imm = reinterpret_cast< const uint8_t * >( &t.imm );
+                for ( int b = 0; b < brq::smt_imm( t.op ); ++b )
+                    out.push_back( imm[ b ] );
+            }
+        }
+
+        /* the individual rewrite rules; each returns the index of an
+         * equivalent (existing or newly created) term, or -1 */
+
+        int rewrite( const Term &t )
+        {
+            auto traits = brq::smt_traits( t.op );
+
+            if ( t.op == op_t::bv_extract )
+                return rewrite_extract( t );
+            if ( t.op == op_t::bv_concat )
+                return rewrite_concat( t );
+            if ( traits.is_resize() )
+                return rewrite_resize( t );
+            if ( t.op == op_t::bool_not || t.op == op_t::bv_not || t.op == op_t::bv_neg )
+                return rewrite_not( t );
+            if ( traits.type == brq::smt_op_compare && !traits.floating )
+                return rewrite_compare( t );
+            if ( traits.type == brq::smt_op_bool )
+                return rewrite_bool( t );
+            if ( traits.arity == 2 && !traits.floating && t.op >= op_t::bv_and && t.op <= op_t::bv_ashr )
+                return rewrite_arith( t );
+            return -1;
+        }
+
+        int rewrite_not( const Term &t )
+        {
+            int a = t.arg[ 0 ];
+            if ( !is_bv( a ) )
+                return -1;
+
+            if ( is_const( a ) && representable( t.bw ) )
+                return mk_const( t.op == op_t::bv_neg ? -val( a ) : ~val( a ), t.bw );
+            if ( op( a ) == t.op )
+                return arg( a, 0 );
+            if ( t.op == op_t::bool_not && is_bool( a ) )
+                if ( auto n = negate( op( a ) ); n != op_t::invalid )
+                    return mk( n, 1, 0, arg( a, 0 ), arg( a, 1 ) );
+            return -1;
+        }
+
+        int rewrite_resize( const Term &t )
+        {
+            int a = t.arg[ 0 ], abw = bw( a );
+            if ( !is_bv( a ) )
+                return -1;
+            if ( abw == t.bw )
+                return a;
+
+            if ( is_const( a ) && representable( t.bw ) )
+                return mk_const( t.op == op_t::bv_sext ? sext( val( a ), abw ) : val( a ), t.bw );
+
+            auto inner = op( a );
+            bool inner_ext = inner == op_t::bv_zext || inner == op_t::bv_sext;
+            int x = arg( a, 0 );
+
+            if ( t.op == op_t::bv_trunc && inner_ext && t.bw > 1 )
+            {
+                if ( t.bw == bw( x ) )
+                    return x;
+                if ( t.bw < bw( x ) )
+                    return mk( op_t::bv_trunc, t.bw, t.bw, x );
+                return mk( inner, t.bw, t.bw, x );
+            }
+
+            if ( t.op == op_t::bv_trunc && inner == op_t::bv_trunc )
+                return mk( op_t::bv_trunc, t.bw, t.bw, x );
+
+            if ( t.op == op_t::bv_zext && inner == op_t::bv_zext )
+                return mk( op_t::bv_zext, t.bw, t.bw, x );
+
+            if ( t.op == op_t::bv_sext && inner_ext )
+                return mk( inner, t.bw, t.bw, x ); /* zext makes the sign bit zero */
+
+            return -1;
+        }
+
+        int rewrite_extract( const Term &t )
+        {
+            int a = t.arg[ 0 ], lo = t.imm & 0xff, hi = ( t.imm >> 8 ) & 0xff;
+            if ( !is_bv( a ) )
+                return -1;
+
+            if ( lo == 0 && hi == bw( a ) - 1 )
+                return a;
+            if ( is_const( a ) && representable( t.bw ) )
+                return mk_const( val( a ) >> lo, t.bw );
+
+            int x = arg( a, 0 );
+
+            switch ( op( a ) )
+            {
+                case op_t::bv_extract:
+                {
+                    int base = val( a ) & 0xff;
+                    return mk_extract( x, base + lo, base + hi );
+                }
+                case op_t::bv_concat:
+                {
+                    int y = arg( a, 1 ), ybw = bw( y );
+                    if ( hi < ybw )
+                        return mk_extract( y, lo, hi );
+                    if ( lo >= ybw )
+                        return mk_extract( x, lo - ybw, hi - ybw );
+                    return -1;
+                }
+                case op_t::bv_zext:
+                case op_t::bv_sext:
+                    if ( bw( x ) < 2 )
+                        return -1;
+                    if ( hi < bw( x ) )
+                        return mk_extract( x, lo, hi );
+                    if ( op( a ) == op_t::bv_zext && lo >= bw( x ) && representable( t.bw ) )
+                        return mk_const( 0, t.bw );
+                    return -1;
+                default:
+                    return -1;
+            }
+        }
+
+        int rewrite_concat( const Term &t )
+        {
+            int a = t.arg[ 0 ], b = t.arg[ 1 ];
+            if ( !is_bv( a ) || !is_bv( b ) )
+                return -1;
+
+            if ( is_const( a ) && is_const( b ) && representable( t.bw ) )
+                return mk_const( val( a ) << bw( b ) | val( b ), t.bw );
+
+            if ( op( a ) == op_t::bv_extract && op( b ) == op_t::bv_extract &&
+                 arg( a, 0 ) == arg( b, 0 ) )
+            {
+                int a_lo = val( a ) & 0xff, a_hi = val( a ) >> 8,
+                    b_lo = val( b ) & 0xff, b_hi = val( b ) >> 8;
+                if ( a_lo == b_hi + 1 )
+                    return mk_extract( arg( a, 0 ), b_lo, a_hi );
+            }
+
+            if ( is_const( a ) && val( a ) == 0 && bw( b ) > 1 )
+                return mk( op_t::bv_zext, t.bw, t.bw, b );
+
+            return -1;
+        }
+
+        static op_t negate( op_t o )
+        {
+            switch ( o )
+            {
+                case op_t::eq:     return op_t::neq;
+                case op_t::neq:    return op_t::eq;
+                case op_t::bv_ult: return op_t::bv_uge;
+                case op_t::bv_uge: return op_t::bv_ult;
+                case op_t::bv_ule: return op_t::bv_ugt;
+                case op_t::bv_ugt: return op_t::bv_ule;
+                case op_t::bv_slt: return op_t::bv_sge;
+                case op_t::bv_sge: return op_t::bv_slt;
+                case op_t::bv_sle: return op_t::bv_sgt;
+                case op_t::bv_sgt: return op_t::bv_sle;
+                default: return op_t::invalid;
+            }
+        }
+
+        static op_t swap( op_t o )
+        {
+            switch ( o )
+            {
+                case op_t::bv_ult: return op_t::bv_ugt;
+                case op_t::bv_ugt: return op_t::bv_ult;
+                case op_t::bv_ule: return op_t::bv_uge;
+                case op_t::bv_uge: return op_t::bv_ule;
+                case op_t::bv_slt: return op_t::bv_sgt;
+                case op_t::bv_sgt: return op_t::bv_slt;
+                case op_t::bv_sle: return op_t::bv_sge;
+                case op_t::bv_sge: return op_t::bv_sle;
+                default: return o;
+            }
+        }
+
+        static bool is_signed( op_t o ) { return o >= op_t::bv_sle && o <= op_t::bv_sgt; }
+        static bool is_unsigned( op_t o ) { return o >= op_t::bv_ule && o <= op_t::bv_ugt; }
+
+        static bool compare( op_t o, uint64_t a, uint64_t b, int bw )
+        {
+            int64_t sa = sext( a, bw ), sb = sext( b, bw );
+            switch ( o )
+            {
+                case op_t::eq:     return a == b;
+                case op_t::neq:    return a != b;
+                case op_t::bv_ult: return a < b;
+                case op_t::bv_ule: return a <= b;
+                case op_t::bv_ugt: return a > b;
+                case op_t::bv_uge: return a >= b;
+                case op_t::bv_slt: return sa < sb;
+                case op_t::bv_sle: return sa <= sb;
+                case op_t::bv_sgt: return sa > sb;
+                case op_t::bv_sge: return sa >= sb;
+                default: UNREACHABLE( "unexpected comparison", o );
+            }
+        }
+
+        int rewrite_compare( const Term &t )
+        {
+            int a = t.arg[ 0 ], b = t.arg[ 1 ];
+            if ( !is_bv( a ) || !is_bv( b ) )
+                return -1;
+
+            if ( is_const( a ) && is_const( b ) )
+                return mk_bool( compare( t.op, val( a ), val( b ), bw( a ) ) );
+
+            if ( a == b )
+                return mk_bool( compare( t.op, 0, 0, bw( a ) ) );
+
+            if ( is_const( a ) ) /* keep constants on the right */
+                return mk( swap( t.op ), 1, 0, b, a );
+
+            /* a boolean compared to a constant is the boolean or its negation */
+            if ( is_const( b ) && is_bool( a ) && ( t.op == op_t::eq || t.op == op_t::neq ) )
+                return ( val( b ) == 1 ) == ( t.op == op_t::eq ) ? a : mk( op_t::bool_not, 1, 0, a );
+
+            auto ext = op( a );
+            if ( ext != op_t::bv_zext && ext != op_t::bv_sext )
+                return -1;
+
+            int x = arg( a, 0 ), xbw = bw( x );
+            if ( xbw < 2 || !representable( xbw ) )
+                return -1;
+
+            bool zext = ext == op_t::bv_zext;
+            bool eq = t.op == op_t::eq || t.op == op_t::neq;
+            if ( !eq && ( zext ? !is_unsigned( t.op ) : !is_signed( t.op ) ) )
+                return -1;
+
+            /* both sides extended the same way from the same width */
+            if ( op( b ) == ext && bw( arg( b, 0 ) ) == xbw )
+                return mk( t.op, 1, 0, x, arg( b, 0 ) );
+
+            if ( !is_const( b ) )
+                return -1;
+
+            /* narrow the comparison to the width of x, unless the constant is
+             * out of range, in which case the result is fixed */
+            if ( zext )
+            {
+                if ( val( b ) <= mask( xbw ) )
+                    return mk( t.op, 1, 0, x, mk_const( val( b ), xbw ) );
+                bool below = t.op == op_t::neq || t.op == op_t::bv_ult || t.op == op_t::bv_ule;
+                return mk_bool( below );
+            }
+            else
+            {
+                int64_t c = sval( b ), max = int64_t( mask( xbw - 1 ) ), min = -max - 1;
+                if ( c >= min && c <= max )
+                    return mk( t.op, 1, 0, x, mk_const( c, xbw ) );
+                if ( eq )
+                    return mk_bool( t.op == op_t::neq );
+                bool lt = t.op == op_t::bv_slt || t.op == op_t::bv_sle;
+                return mk_bool( c > max ? lt : !lt );
+            }
+        }
+
+        int rewrite_bool( const Term &t )
+        {
+            int a = t.arg[ 0 ], b = t.arg[ 1 ];
+            if ( !is_bv( a ) || !is_bv( b ) )
+                return -1;
+
+            if ( is_const( a ) && is_const( b ) )
+            {
+                bool x = val( a ), y = val( b );
+                switch ( t.op )
+                {
+                    case op_t::bool_and:   return mk_bool( x && y );
+                    case op_t::bool_or:    return mk_bool( x || y );
+                    case op_t::bool_xor:   return mk_bool( x != y );
+                    case op_t::bool_imply: return mk_bool( !x || y );
+                    default: return -1;
+                }
+            }
+
+            if ( a == b )
+                switch ( t.op )
+                {
+                    case op_t::bool_and:
+                    case op_t::bool_or:    return a;
+                    case op_t::bool_xor:   return mk_bool( false );
+                    case op_t::bool_imply: return mk_bool( true );
+                    default: return -1;
+                }
+
+            if ( is_const( a ) && t.op == op_t::bool_imply )
+                return val( a ) ? b : mk_bool( true );
+
+            if ( is_const( a ) ) /* the remaining operators are commutative */
+                std::swap( a, b );
+            if ( !is_const( b ) )
+                return -1;
+
+            bool y = val( b );
+            switch ( t.op )
+            {
+                case op_t::bool_and:   return y ? a : mk_bool( false );
+                case op_t::bool_or:    return y ? mk_bool( true ) : a;
+                case op_t::bool_xor:   return y ? mk( op_t::bool_not, 1, 0, a ) : a;
+                case op_t::bool_imply: return y ? mk_bool( true ) : mk( op_t::bool_not, 1, 0, a );
+                default: return -1;
+            }
+        }
+
+        static bool fold( op_t o, uint64_t a, uint64_t b, int bw, uint64_t &r )
+        {
+            int64_t sa = sext( a, bw ), sb = sext( b, bw );
+            switch ( o )
+            {
+                case op_t::bv_and: r = a & b; break;
+                case op_t::bv_or:  r = a | b; break;
+                case op_t::bv_xor: r = a ^ b; break;
+                case op_t::bv_add: r = a + b; break;
+                case op_t::bv_sub: r = a - b; break;
+                case op_t::bv_mul: r = a * b; break;
+                case op_t::bv_udiv: if ( !b ) return false; r = a / b; break;
+                case op_t::bv_urem: if ( !b ) return false; r = a % b; break;
+                case op_t::bv_sdiv:
+                    if ( !b ) return false;
+                    r = sb == -1 ? -a : uint64_t( sa / sb ); break;
+                case op_t::bv_srem:
+                    if ( !b ) return false;
+                    r = sb == -1 ? 0 : uint64_t( sa % sb ); break;
+                case op_t::bv_shl:  r = b >= uint64_t( bw ) ? 0 : a << b; break;
+                case op_t::bv_lshr: r = b >= uint64_t( bw ) ? 0 : a >> b; break;
+                case op_t::bv_ashr: r = uint64_t( sa >> std::min( b, uint64_t( 63 ) ) ); break;
+                default: return false;
+            }
+            r &= mask( bw );
+            return true;
+        }
+
+        int rewrite_arith( const Term &t )
+        {
+            int a = t.arg[ 0 ], b = t.arg[ 1 ];
+            if ( !is_bv( a ) || !is_bv( b ) || !representable( t.bw ) || bw( a ) != bw( b ) )
+                return -1;
+
+            if ( uint64_t r; is_const( a ) && is_const( b ) && fold( t.op, val( a ), val( b ), t.bw, r ) )
+                return mk_const( r, t.bw );
+
+            if ( a == b )
+                switch ( t.op )
+                {
+                    case op_t::bv_and:
+                    case op_t::bv_or:  return a;
+                    case op_t::bv_sub:
+                    case op_t::bv_xor: return mk_const( 0, t.bw );
+                    default: return -1;
+                }
+
+            bool commutes = t.op == op_t::bv_and || t.op == op_t::bv_or || t.op == op_t::bv_xor ||
+                            t.op == op_t::bv_add || t.op == op_t::bv_mul;
+            if ( is_const( a ) && commutes )
+                std::swap( a, b );
+            if ( !is_const( b ) )
+                return -1;
+
+            uint64_t c = val( b ), ones = mask( t.bw );
+            switch ( t.op )
+            {
+                case op_t::bv_add: case op_t::bv_sub: case op_t::bv_or: case op_t::bv_xor:
+                case op_t::bv_shl: case op_t::bv_lshr: case op_t::bv_ashr:
+                    if ( c == 0 ) return a;
+                    if ( t.op == op_t::bv_or && c == ones ) return b;
+                    return -1;
+                case op_t::bv_mul:
+                    return c == 0 ? b : c == 1 ? a : -1;
+                case op_t::bv_and:
+                    return c == 0 ? b : c == ones ? a : -1;
+                case op_t::bv_udiv: case op_t::bv_sdiv:
+                    return c == 1 ? a : -1;
+                default:
+                    return -1;
+            }
+        }
+
+        /* Interval reasoning over the top-level conjunction. Each conjunct of
+         * the form (x op c), where x is a variable and c is a constant,
+         * narrows the unsigned and signed range of x or excludes a single
+         * value. Returns false if some variable has no admissible value
+         * left, true if all conjuncts were of the above form (the variables
+         * are then independent) and maybe otherwise. */
+
+        struct Range
+        {
+            int bw = 0;
+            uint64_t ulo = 0, uhi = 0;
+            int64_t slo = 0, shi = 0;
+            bool empty = false;
+            std::vector< uint64_t > excl;
+
+            Range() = default;
+            Range( int bw )
+                : bw( bw ), ulo( 0 ), uhi( mask( bw ) ),
+                  slo( -int64_t( mask( bw - 1 ) ) - 1 ), shi( int64_t( mask( bw - 1 ) ) )
+            {}
+
+            void constrain( op_t o, uint64_t c )
+            {
+                int64_t sc = sext( c, bw );
+                switch ( o )
+                {
+                    case op_t::eq:
+                        ulo = std::max( ulo, c ); uhi = std::min( uhi, c );
+                        slo = std::max( slo, sc ); shi = std::min( shi, sc ); break;
+                    case op_t::neq: excl.push_back( c ); break;
+                    case op_t::bv_ult: if ( c == 0 ) empty = true; else uhi = std::min( uhi, c - 1 ); break;
+                    case op_t::bv_ule: uhi = std::min( uhi, c ); break;
+                    case op_t::bv_ugt: if ( c == mask( bw ) ) empty = true; else ulo = std::max( ulo, c + 1 ); break;
+                    case op_t::bv_uge: ulo = std::max( ulo, c ); break;
+                    case op_t::bv_slt: if ( sc == slo_min() ) empty = true; else shi = std::min( shi, sc - 1 ); break;
+                    case op_t::bv_sle: shi = std::min( shi, sc ); break;
+                    case op_t::bv_sgt: if ( sc == shi_max() ) empty = true; else slo = std::max( slo, sc + 1 ); break;
+                    case op_t::bv_sge: slo = std::max( slo, sc ); break;
+                    default: UNREACHABLE( "unexpected comparison", o );
+                }
+            }
+
+            int64_t slo_min() const { return -int64_t( mask( bw - 1 ) ) - 1; }
+            int64_t shi_max() const { return int64_t( mask( bw - 1 ) ); }
+
+            /* find some value in [lo, hi] which is not excluded */
+            bool witness( uint64_t lo, uint64_t hi ) const
+            {
+                lo = std::max( lo, ulo );
+                hi = std::min( hi, uhi );
+                for ( size_t i = 0; lo <= hi && i <= excl.size(); ++i, ++lo )
+                {
+                    if ( std::find( excl.begin(), excl.end(), lo ) == excl.end() )
+                        return true;
+                    if ( lo == hi )
+                        break;
+                }
+                return false;
+            }
+
+            bool satisfiable() const
+            {
+                if ( empty || ulo > uhi || slo > shi )
+                    return false;
+
+                uint64_t m = mask( bw );
+                if ( slo >= 0 || shi < 0 ) /* the signed range maps to one unsigned range */
+                    return witness( uint64_t( slo ) & m, uint64_t( shi ) & m );
+                return witness( 0, uint64_t( shi ) ) || witness( uint64_t( slo ) & m, m );
+            }
+        };
+
+        brq::tristate decide() const
+        {
+            if ( _root < 0 )
+                return brq::maybe;
+            if ( constant() )
+                return brq::tristate( value() );
+
+            std::unordered_map< uint64_t, Range > vars;
+            std::vector< int > work{ _root };
+            bool exact = true;
+
+            auto atom = [&]( int v, op_t o, uint64_t c )
+            {
+                auto it = vars.find( val( v ) );
+                if ( it == vars.end() )
+                    it = vars.emplace( val( v ), Range( bw( v ) ) ).first;
+                it->second.constrain( o, c );
+            };
+
+            while ( !work.empty() )
+            {
+                int c = work.back();
+                work.pop_back();
+
+                auto o = op( c );
+                if ( o == op_t::bool_and || ( o == op_t::bv_and && bw( c ) == 1 ) )
+                    work.push_back( arg( c, 0 ) ), work.push_back( arg( c, 1 ) );
+                else if ( is_const( c ) )
+                {
+                    if ( !val( c ) )
+                        return brq::tristate( false );
+                }
+                else if ( o == op_t::var_i1 )
+                    atom( c, op_t::eq, 1 );
+                else if ( ( o == op_t::bool_not || o == op_t::bv_not ) && op( arg( c, 0 ) ) == op_t::var_i1 )
+                    atom( arg( c, 0 ), op_t::eq, 0 );
+                else if ( is_bool( c ) && brq::smt_traits( o ).type == brq::smt_op_compare &&
+                          negate( o ) != op_t::invalid &&
+                          is_var_op( op( arg( c, 0 ) ) ) && is_const( arg( c, 1 ) ) )
+                    atom( arg( c, 0 ), o, val( arg( c, 1 ) ) );
+                else
+                    exact = false;
+            }
+
+            for ( auto &[ id, r ] : vars )
+                if ( !r.satisfiable() )
+                    return brq::tristate( false );
+
+            return exact ? brq::tristate( true ) : brq::tristate( brq::maybe );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
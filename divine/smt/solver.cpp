@@ -1,5 +1,7 @@
 #include <divine/smt/solver.hpp>
 #include <divine/smt/builder.hpp>
+#include <divine/smt/simplify.hpp>
+#include <divine/smt/intervals.hpp>
 #include <divine/vm/memory.hpp>
 #include <brick-proc>
 #include <brick-bitlevel>
@@ -11,6 +13,15 @@ namespace divine::smt::solver
 
 using op_t = brq::smt_op;
 
+/* try to settle a feasibility query without calling the solver: first by
+ * looking at simple variable bounds, then by interval propagation */
+static brq::tristate prefilter( const Simplify &simp )
+{
+    if ( auto trivial = simp.decide(); !brq::maybe( trivial ) )
+        return trivial;
+    return Intervals( simp ).decide();
+}
+
 Result SMTLib::solve()
 {
     auto b = builder( 'z' - 'a' );
@@ -48,42 +59,102 @@ op_t equality( const Node& node ) noexcept
 }
 
 template< typename Core >
-bool Simple< Core >::equal( vm::HeapPointer path, SymPairs &sym_pairs,
-                            vm::CowHeap &h_1, vm::CowHeap &h_2 )
+Result Simple< Core >::solve_match( const std::vector< expr_t > &exprs, corpus::Kind kind )
 {
-    equality_timer _t;
+    equality_latency _l;
     this->reset();
-    auto e_1 = this->extract( h_1, 1 ), e_2 = this->extract( h_2, 2 );
     auto b = this->builder();
+    auto b_1 = this->builder( 1 ), b_2 = this->builder( 2 );
 
     auto v_eq = b.constant( true );
-    auto c_1_rpn = e_1.read_constraints( path ),
-         c_2_rpn = e_2.read_constraints( path );
-    auto c_1 = c_1_rpn.empty() ? b.constant( true ) : evaluate( e_1, c_1_rpn ),
-         c_2 = c_2_rpn.empty() ? b.constant( true ) : evaluate( e_2, c_2_rpn );
+    auto c_1 = exprs[ 0 ].empty() ? b.constant( true ) : evaluate( b_1, exprs[ 0 ] ),
+         c_2 = exprs[ 1 ].empty() ? b.constant( true ) : evaluate( b_2, exprs[ 1 ] );
 
-    for ( auto [lhs, rhs] : sym_pairs )
+    for ( size_t i = 2; i < exprs.size(); i += 2 )
     {
-        auto f_1 = e_1.read( lhs );
-        auto f_2 = e_2.read( rhs );
-
-        auto v_1 = evaluate( e_1, f_1 );
-        auto v_2 = evaluate( e_2, f_2 );
+        auto v_1 = evaluate( b_1, exprs[ i ] );
+        auto v_2 = evaluate( b_2, exprs[ i + 1 ] );
 
         brq::smt_op op = equality< Core >( v_1 );
         auto pair_eq = mk_bin( b, op, 1, v_1, v_2 );
         v_eq = mk_bin( b, op_t::bool_and, 1, v_eq, pair_eq );
     }
 
-    /* we already know that both constraint sets are sat */
-    auto c_eq = mk_bin( b, op_t::eq, 1, c_1, c_2 ),
-      pc_fail = mk_un(  b, op_t::bool_not, 1, c_1 ),
-       v_eq_c = mk_bin( b, op_t::bool_or, 1, pc_fail, v_eq ),
-           eq = mk_bin( b, op_t::bool_and, 1, c_eq, v_eq_c );
+    if ( kind == corpus::Kind::Subsumes )
+    {
+        /* look for a valuation admitted by the second state but not covered
+         * by the first one, either in the path condition or in the values */
+        auto covered = mk_bin( b, op_t::bool_and, 1, c_1, v_eq ),
+           uncovered = mk_un(  b, op_t::bool_not, 1, covered );
+        this->add( mk_bin( b, op_t::bool_and, 1, c_2, uncovered ) );
+    }
+    else
+    {
+        /* we already know that both constraint sets are sat */
+        auto c_eq = mk_bin( b, op_t::eq, 1, c_1, c_2 ),
+          pc_fail = mk_un(  b, op_t::bool_not, 1, c_1 ),
+           v_eq_c = mk_bin( b, op_t::bool_or, 1, pc_fail, v_eq ),
+               eq = mk_bin( b, op_t::bool_and, 1, c_eq, v_eq_c );
+
+        this->add( mk_un( b, op_t::bool_not, 1, eq ) );
+    }
 
-    this->add( mk_un( b, op_t::bool_not, 1, eq ) );
     auto r = this->solve();
     this->reset();
+    return r;
+}
+
+template< typename Core >
+Result Simple< Core >::solve_feasible( const expr_t &expr )
+{
+    feasibility_latency _l;
+    this->reset();
+    auto b = this->builder( 1 );
+    auto query = evaluate( b, expr );
+    this->add( mk_bin( b, op_t::eq, 1, query, b.constant( 1, 1 ) ) );
+    return this->solve();
+}
+
+template< typename Core >
+Result Simple< Core >::replay( const corpus::Query &q )
+{
+    switch ( q.kind )
+    {
+        case corpus::Kind::Feasible: return solve_feasible( q.exprs[ 0 ] );
+        case corpus::Kind::Equal:
+        case corpus::Kind::Subsumes: return solve_match( q.exprs, q.kind );
+        default: UNREACHABLE( "unexpected query kind" );
+    }
+}
+
+template< typename Core >
+Result Simple< Core >::check_feasible( const expr_t &expr )
+{
+    if ( !corpus::recorder() )
+        return solve_feasible( expr );
+    return corpus::record( corpus::Kind::Feasible, { expr },
+                           [&] { return solve_feasible( expr ); } );
+}
+
+template< typename Core >
+bool Simple< Core >::match( vm::HeapPointer path, SymPairs &sym_pairs,
+                            vm::CowHeap &h_1, vm::CowHeap &h_2, corpus::Kind kind )
+{
+    equality_timer _t;
+    auto e_1 = this->extract( h_1, 1 ), e_2 = this->extract( h_2, 2 );
+    std::vector< expr_t > exprs{ e_1.read_constraints( path ), e_2.read_constraints( path ) };
+
+    for ( auto [lhs, rhs] : sym_pairs )
+    {
+        exprs.push_back( e_1.read( lhs ) );
+        exprs.push_back( e_2.read( rhs ) );
+    }
+
+    Result r;
+    if ( corpus::recorder() )
+        r = corpus::record( kind, exprs, [&] { return solve_match( exprs, kind ); } );
+    else
+        r = solve_match( exprs, kind );
     return r == Result::False;
 }
 
@@ -91,12 +162,114 @@ template< typename Core >
 bool Simple< Core >::feasible( vm::CowHeap & heap, vm::HeapPointer ptr )
 {
     feasibility_timer _t;
-    this->reset();
     auto e = this->extract( heap, 1 );
-    auto b = this->builder();
-    auto query = evaluate( e, e.read( ptr ) );
-    this->add( mk_bin( b, op_t::eq, 1, query, b.constant( 1, 1 ) ) );
-    return this->solve() != Result::False;
+    Simplify simp;
+    auto expr = simp.run( e.read( ptr ) );
+
+    if ( auto trivial = prefilter( simp ); !brq::maybe( trivial ) )
+        return bool( trivial );
+
+    return check_feasible( expr ) != Result::False;
+}
+
+template< typename Core >
+void Simple< Core >::enqueue( Batch &batch, int owner, vm::CowHeap &heap, vm::HeapPointer ptr )
+{
+    if ( !batch.result[ owner ] )
+        return;
+
+    feasibility_timer _t;
+    auto e = this->extract( heap, 1 );
+    Simplify simp;
+    auto expr = simp.run( e.read( ptr ) );
+
+    if ( auto trivial = prefilter( simp ); !brq::maybe( trivial ) )
+    {
+        if ( !trivial )
+            batch.result[ owner ] = false;
+        return;
+    }
+
+    batch.add( owner, std::move( expr ) );
+}
+
+template< typename Core >
+void Simple< Core >::solve( Batch &batch )
+{
+    feasibility_timer _t;
+    std::vector< int > index;
+    auto results = solve_batch( batch.unique( index ) );
+    batch.settle( index, [&]( int i ) { return results[ i ] != Result::False; } );
+}
+
+/* The queries in a batch usually come from the successors of a single state
+ * and share most of their path condition. The conjuncts common to all of
+ * them are asserted once, and the remainder of each query is then solved in
+ * its own push/pop scope on top of those. */
+
+template< typename Core >
+std::vector< Result > Simple< Core >::solve_batch( const std::vector< expr_t > &exprs )
+{
+    std::vector< Result > rv;
+    std::vector< std::vector< expr_t > > parts;
+    std::unordered_map< std::string_view, size_t > count;
+
+    auto key = []( const expr_t &e )
+    {
+        return std::string_view( reinterpret_cast< const char * >( e.base::data() ), e.base::size() );
+    };
+
+    if ( exprs.size() > 1 && !corpus::recorder() ) /* the corpus wants whole queries */
+        for ( auto &e : exprs )
+        {
+            Simplify simp;
+            simp.run( e );
+            parts.push_back( simp.conjuncts() );
+            if ( parts.back().empty() )
+                parts.back().push_back( e );
+
+            std::sort( parts.back().begin(), parts.back().end() );
+            parts.back().erase( std::unique( parts.back().begin(), parts.back().end() ),
+                                parts.back().end() );
+        }
+
+    for ( auto &p : parts )
+        for ( auto &c : p )
+            ++ count[ key( c ) ];
+
+    auto common = [&]( const expr_t &c ) { return count[ key( c ) ] == exprs.size(); };
+
+    if ( parts.empty() || std::none_of( parts[ 0 ].begin(), parts[ 0 ].end(), common ) )
+    {
+        for ( auto &e : exprs )
+            rv.push_back( check_feasible( e ) );
+        return rv;
+    }
+
+    this->reset();
+    auto b = this->builder( 1 );
+    auto assert_true = [&]( const expr_t &c )
+    {
+        this->add( mk_bin( b, op_t::eq, 1, evaluate( b, c ), b.constant( 1, 1 ) ) );
+    };
+
+    for ( auto &c : parts[ 0 ] )
+        if ( common( c ) )
+            assert_true( c );
+
+    for ( auto &p : parts )
+    {
+        feasibility_latency _l;
+        this->push();
+        for ( auto &c : p )
+            if ( !common( c ) )
+                assert_true( c );
+        rv.push_back( this->solve() );
+        this->pop();
+    }
+
+    this->reset();
+    return rv;
 }
 
 template< typename Core >
@@ -116,20 +289,46 @@ bool Caching< Core >::feasible( vm::CowHeap &heap, vm::HeapPointer ptr )
 {
     feasibility_timer _t;
     auto extract = this->extract( heap, 1 );
-    auto expr = extract.read( ptr );
+    Simplify simp;
+    auto expr = simp.run( extract.read( ptr ) );
+
+    if ( auto trivial = prefilter( simp ); !brq::maybe( trivial ) )
+        return bool( trivial );
 
     if ( auto hit = _cache.find( item{ expr, 0, 0 } ); hit.valid() )
         return ++ hit->hits, hit->sat;
 
-    this->reset();
-    auto b = this->builder();
-    auto query = evaluate( extract, expr );
-    this->add( mk_bin( b, op_t::eq, 1, query, b.constant( 1, 1 ) ) );
-    bool rv = this->solve() != Result::False;
+    bool rv = this->check_feasible( expr ) != Result::False;
     _cache.insert( item{ expr, 0, rv } );
     return rv;
 }
 
+template< typename Core >
+void Caching< Core >::solve( Batch &batch )
+{
+    feasibility_timer _t;
+    std::vector< int > index, missed;
+    std::vector< Batch::expr_t > queries = batch.unique( index ), misses;
+    std::vector< bool > sat( queries.size() );
+
+    for ( size_t i = 0; i < queries.size(); ++i )
+        if ( auto hit = _cache.find( item{ queries[ i ], 0, 0 } ); hit.valid() )
+            ++ hit->hits, sat[ i ] = hit->sat;
+        else
+            misses.push_back( queries[ i ] ), missed.push_back( i );
+
+    auto results = this->solve_batch( misses );
+
+    for ( size_t i = 0; i < misses.size(); ++i )
+    {
+        bool rv = results[ i ] != Result::False;
+        _cache.insert( item{ misses[ i ], 0, rv } );
+        sat[ missed[ i ] ] = rv;
+    }
+
+    batch.settle( index, [&]( int i ) { return sat[ i ]; } );
+}
+
 template< typename Core >
 bool Incremental< Core >::feasible( vm::CowHeap &/*heap*/, vm::HeapPointer /*ptr*/ )
 {
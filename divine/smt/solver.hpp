@@ -23,7 +23,10 @@
 #include <divine/smt/builder.hpp>
 #include <divine/smt/extract.hpp>
 #include <divine/smt/model.hpp>
+#include <divine/smt/corpus.hpp>
 #include <vector>
+#include <unordered_map>
+#include <string_view>
 #include <brick-except>
 #include <brick-timer>
 
@@ -44,6 +47,11 @@ namespace divine::smt
 
     using feasibility_timer = brq::timer< feasibility_timer_tag >;
     using equality_timer    = brq::timer< equality_timer_tag >;
+
+    /* latencies of the individual queries which reach the solver (i.e. were
+     * not decided by the prefilter or the cache) */
+    using feasibility_latency = brq::histogram< feasibility_timer_tag >;
+    using equality_latency    = brq::histogram< equality_timer_tag >;
 }
 
 namespace divine::smt::solver
@@ -54,9 +62,60 @@ using namespace std::literals;
 using SymPairs = std::vector< std::pair< vm::HeapPointer, vm::HeapPointer > >;
 enum class Result { False, True, Unknown };
 
+/* Feasibility queries collected from all the successors of a state, so that
+ * they can be deduplicated and solved together. Each successor registers as
+ * an owner, and is feasible iff all of its queries are. */
+struct Batch
+{
+    using expr_t = brq::smt_expr< std::vector >;
+
+    std::vector< std::pair< int, expr_t > > pending; /* owner, query */
+    std::vector< bool > result;                        /* by owner */
+
+    int owner() { result.push_back( true ); return result.size() - 1; }
+    void add( int owner, expr_t q ) { pending.emplace_back( owner, std::move( q ) ); }
+    void clear() { pending.clear(); result.clear(); }
+
+    /* the distinct queries of owners which are not yet known infeasible,
+     * with the index into the former for each pending query */
+    std::vector< expr_t > unique( std::vector< int > &index ) const
+    {
+        std::vector< expr_t > rv;
+        std::unordered_map< std::string_view, int > seen;
+        index.clear();
+
+        for ( auto &[ o, q ] : pending )
+        {
+            if ( !result[ o ] )
+            {
+                index.push_back( -1 );
+                continue;
+            }
+
+            std::string_view key( reinterpret_cast< const char * >( q.base::data() ), q.base::size() );
+            auto [ it, fresh ] = seen.emplace( key, rv.size() );
+            if ( fresh )
+                rv.push_back( q );
+            index.push_back( it->second );
+        }
+
+        return rv;
+    }
+
+    template< typename F >
+    void settle( const std::vector< int > &index, F is_feasible )
+    {
+        for ( size_t i = 0; i < pending.size(); ++i )
+            if ( index[ i ] >= 0 && !is_feasible( index[ i ] ) )
+                result[ pending[ i ].first ] = false;
+        pending.clear();
+    }
+};
+
 struct None
 {
     bool equal( vm::HeapPointer, SymPairs &, vm::CowHeap &, vm::CowHeap & ) { return true; }
+    bool subsumes( vm::HeapPointer, SymPairs &, vm::CowHeap &, vm::CowHeap & ) { return false; }
 
     bool feasible( vm::CowHeap &, vm::HeapPointer a )
     {
@@ -65,6 +124,9 @@ struct None
         return true;
     }
 
+    void enqueue( Batch &, int, vm::CowHeap &h, vm::HeapPointer a ) { feasible( h, a ); }
+    void solve( Batch & ) {}
+
     void reset() {}
 
     Model model( vm::CowHeap &, vm::HeapPointer )
@@ -78,10 +140,37 @@ struct None
 template< typename Core >
 struct Simple : Core
 {
+    using expr_t = brq::smt_expr< std::vector >;
     using Core::Core;
-    bool equal( vm::HeapPointer path, SymPairs &sym_pairs, vm::CowHeap &h1, vm::CowHeap &h2 );
+    using Core::solve;
+    bool equal( vm::HeapPointer path, SymPairs &sym_pairs, vm::CowHeap &h1, vm::CowHeap &h2 )
+    {
+        return match( path, sym_pairs, h1, h2, corpus::Kind::Equal );
+    }
+
+    /* is every valuation admitted by the state in h2 also admitted by the
+     * state in h1, with the same values of the symbolic pairs? */
+    bool subsumes( vm::HeapPointer path, SymPairs &sym_pairs, vm::CowHeap &h1, vm::CowHeap &h2 )
+    {
+        return match( path, sym_pairs, h1, h2, corpus::Kind::Subsumes );
+    }
+
+    bool match( vm::HeapPointer path, SymPairs &sym_pairs, vm::CowHeap &h1, vm::CowHeap &h2,
+                corpus::Kind kind );
     bool feasible( vm::CowHeap & heap, vm::HeapPointer assumes );
 
+    /* deferred feasibility checks: enqueue settles what it can right away
+     * (trivial queries), solve() takes care of the rest */
+    void enqueue( Batch &batch, int owner, vm::CowHeap &heap, vm::HeapPointer assumes );
+    void solve( Batch &batch );
+    std::vector< Result > solve_batch( const std::vector< expr_t > &exprs );
+
+    /* the heap-independent part of the above, used for query replay */
+    Result solve_match( const std::vector< expr_t > &exprs, corpus::Kind kind );
+    Result solve_feasible( const expr_t &expr );
+    Result check_feasible( const expr_t &expr );
+    Result replay( const corpus::Query &q );
+
     Model model( vm::CowHeap & heap, vm::HeapPointer path );
 };
 
@@ -108,6 +197,8 @@ struct Caching : Simple< Core >
 
     using Simple< Core >::Simple;
     bool feasible( vm::CowHeap & heap, vm::HeapPointer assumes );
+    using Simple< Core >::solve;
+    void solve( Batch &batch );
     brq::concurrent_hash_set< item > _cache;
 };
 
@@ -116,8 +207,10 @@ struct SMTLib
     using Options = std::vector< std::string >;
     SMTLib( const Options &opts ) : _opts{ opts } {}
 
-    void reset() { _asserts.clear(); _ctx.clear(); }
+    void reset() { _asserts.clear(); _marks.clear(); _ctx.clear(); }
     void add( brq::smtlib_node p ) { _asserts.push_back( p ); }
+    void push() { _marks.push_back( _asserts.size() ); }
+    void pop() { _asserts.erase( _asserts.begin() + _marks.back(), _asserts.end() ); _marks.pop_back(); }
 
     Result solve();
 
@@ -134,6 +227,7 @@ struct SMTLib
     auto model() { return Model{}; }
 
     std::vector< brq::smtlib_node > _asserts;
+    std::vector< size_t > _marks;
     brq::smtlib_context _ctx;
     Options _opts;
 };
@@ -0,0 +1,133 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/smt/intervals.hpp>
+#include <divine/smt/t-simplify.hpp>
+
+namespace divine::t_smt
+{
+    struct intervals : formula
+    {
+        Simplify s;
+
+        brq::tristate decide()
+        {
+            s.run( expr );
+            return Intervals( s ).decide();
+        }
+
+        bool sat() { return bool( decide() ); }
+        bool unsat() { return bool( !decide() ); }
+        bool unknown() { return brq::maybe( decide() ); }
+
+        TEST( sum_bound )
+        {
+            range( 1, 0, 10 );
+            range( 2, 0, 10 );
+            apply( op::bool_and );
+            var( 1 ); var( 2 ); apply( op::bv_add ); c32( 20 ); apply( op::bv_uge );
+            apply( op::bool_and );
+            ASSERT( unsat() );
+        }
+
+        TEST( sum_sat )
+        {
+            range( 1, 0, 10 );
+            range( 2, 0, 10 );
+            apply( op::bool_and );
+            var( 1 ); var( 2 ); apply( op::bv_add ); c32( 17 ); apply( op::bv_uge );
+            apply( op::bool_and );
+            ASSERT( sat() );
+        }
+
+        TEST( chain ) /* x < y, y < z, z < 2 */
+        {
+            var( 1 ); var( 2 ); apply( op::bv_ult );
+            var( 2 ); var( 3 ); apply( op::bv_ult ); apply( op::bool_and );
+            var( 3 ); c32( 2 ); apply( op::bv_ult ); apply( op::bool_and );
+            ASSERT( unsat() );
+        }
+
+        TEST( chain_sat ) /* x < y, y < z, z < 3 */
+        {
+            var( 1 ); var( 2 ); apply( op::bv_ult );
+            var( 2 ); var( 3 ); apply( op::bv_ult ); apply( op::bool_and );
+            var( 3 ); c32( 3 ); apply( op::bv_ult ); apply( op::bool_and );
+            ASSERT( sat() );
+        }
+
+        TEST( backward_sub )
+        {
+            range( 1, 10, 20 );
+            var( 1 ); c32( 5 ); apply( op::bv_sub ); c32( 3 ); apply( op::bv_ult );
+            apply( op::bool_and );
+            ASSERT( unsat() );
+        }
+
+        TEST( zext )
+        {
+            var( 1, op::var_i8 ); resize( op::bv_zext, 32 );
+            var( 2, op::var_i8 ); resize( op::bv_zext, 32 );
+            apply( op::bv_add ); c32( 510 ); apply( op::bv_ugt );
+            ASSERT( unsat() );
+        }
+
+        TEST( wrap ) /* x + 1 < x has a solution due to overflow */
+        {
+            var( 1, op::var_i8 ); c8( 1 ); apply( op::bv_add );
+            var( 1, op::var_i8 ); apply( op::bv_ult );
+            ASSERT( !unsat() );
+        }
+
+        TEST( wide ) /* 64-bit values are not tracked */
+        {
+            var( 1, op::var_i64 ); var( 2, op::var_i64 ); apply( op::bv_ult );
+            var( 2, op::var_i64 ); var( 1, op::var_i64 ); apply( op::bv_ult );
+            apply( op::bool_and );
+            ASSERT( !sat() );
+        }
+
+        TEST( disjunction )
+        {
+            range( 1, 0, 4 );
+            var( 1 ); c32( 7 ); apply( op::eq );
+            var( 1 ); c32( 9 ); apply( op::eq );
+            apply( op::bool_or );
+            apply( op::bool_and );
+            ASSERT( unsat() );
+        }
+
+        TEST( extract_offset ) /* x < 256, x[8:15] = 0, x % 8 = 3 */
+        {
+            range( 1, 0, 256 );
+            var( 1 ); extract( 8, 15 ); c8( 0 ); apply( op::eq ); apply( op::bool_and );
+            var( 1 ); c32( 8 ); apply( op::bv_urem ); c32( 3 ); apply( op::eq ); apply( op::bool_and );
+            ASSERT( !unsat() );
+        }
+
+        TEST( urem )
+        {
+            var( 1 ); c32( 8 ); apply( op::bv_urem ); c32( 7 ); apply( op::bv_ugt );
+            ASSERT( unsat() );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
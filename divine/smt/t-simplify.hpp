@@ -0,0 +1,333 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/smt/simplify.hpp>
+#include <brick-assert>
+
+namespace divine::t_smt
+{
+    using namespace divine::smt;
+
+    struct formula
+    {
+        using expr_t = brq::smt_expr< std::vector >;
+        using op = brq::smt_op;
+
+        expr_t expr;
+
+        void var( int id, op o = op::var_i32 ) { expr.apply( brq::smt_atom_t< brq::smt_varid_t >( o, id ) ); }
+        void c8( uint8_t v )   { expr.apply( brq::smt_atom_t< uint8_t >( op::const_i8, v ) ); }
+        void c32( uint32_t v ) { expr.apply( brq::smt_atom_t< uint32_t >( op::const_i32, v ) ); }
+        void b( bool v )       { expr.apply( brq::smt_atom_t< uint8_t >( op::const_i1, v ) ); }
+        void resize( op o, int bw ) { expr.apply( brq::smt_atom_t< uint8_t >( o, uint8_t( bw ) ) ); }
+        void extract( int lo, int hi )
+        {
+            using bounds = std::pair< uint8_t, uint8_t >;
+            expr.apply( brq::smt_atom_t< bounds >( op::bv_extract, bounds( lo, hi ) ) );
+        }
+        void apply( op o ) { expr.apply( o ); }
+
+        /* x in [lo, hi) */
+        void range( int x, uint32_t lo, uint32_t hi )
+        {
+            var( x ); c32( lo ); apply( op::bv_uge );
+            var( x ); c32( hi ); apply( op::bv_ult );
+            apply( op::bool_and );
+        }
+    };
+
+    struct simplify : formula
+    {
+        Simplify s;
+
+        expr_t run() { return s.run( expr ); }
+        bool sat() { return bool( s.decide() ); }
+        bool unsat() { return bool( !s.decide() ); }
+        bool unknown() { return brq::maybe( s.decide() ); }
+
+        expr_t other( std::function< void( formula & ) > f )
+        {
+            formula g;
+            f( g );
+            return g.expr;
+        }
+
+        TEST( fold_arith )
+        {
+            c32( 3 ); c32( 4 ); apply( op::bv_add );
+            c32( 5 ); apply( op::bv_mul );
+            auto r = run();
+            ASSERT_EQ( r.begin()->op, op::const_i32 );
+            ASSERT_EQ( r.begin()->value(), 35 );
+            ASSERT( ++r.begin() == r.end() );
+        }
+
+        TEST( fold_wrap )
+        {
+            c8( 200 ); c8( 100 ); apply( op::bv_add );
+            auto r = run();
+            ASSERT_EQ( r.begin()->value(), 44 );
+        }
+
+        TEST( fold_signed )
+        {
+            c8( 0xf6 ); c8( 3 ); apply( op::bv_sdiv ); /* -10 / 3 */
+            auto r = run();
+            ASSERT_EQ( r.begin()->value(), 0xfd );
+        }
+
+        TEST( no_fold_div_zero )
+        {
+            c32( 3 ); c32( 0 ); apply( op::bv_udiv );
+            ASSERT( run() == expr );
+        }
+
+        TEST( fold_compare )
+        {
+            c32( 3 ); c32( 5 ); apply( op::bv_ult );
+            s.run( expr );
+            ASSERT( s.constant() );
+            ASSERT( s.value() );
+        }
+
+        TEST( identity )
+        {
+            var( 1 ); c32( 0 ); apply( op::bv_add );
+            c32( 1 ); apply( op::bv_mul );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1 ); } ) );
+        }
+
+        TEST( self_sub )
+        {
+            var( 1 ); var( 1 ); apply( op::bv_sub );
+            auto r = run();
+            ASSERT_EQ( r.begin()->op, op::const_i32 );
+            ASSERT_EQ( r.begin()->value(), 0 );
+        }
+
+        TEST( extract_concat )
+        {
+            var( 1, op::var_i8 ); var( 2, op::var_i8 ); apply( op::bv_concat );
+            extract( 8, 15 );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1, op::var_i8 ); } ) );
+        }
+
+        TEST( concat_extract )
+        {
+            var( 1 ); extract( 8, 15 );
+            var( 1 ); extract( 0, 7 );
+            apply( op::bv_concat );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1 ); f.extract( 0, 15 ); } ) );
+        }
+
+        TEST( extract_extract )
+        {
+            var( 1 ); extract( 8, 23 ); extract( 0, 7 );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1 ); f.extract( 8, 15 ); } ) );
+        }
+
+        TEST( resize_chain )
+        {
+            var( 1, op::var_i8 ); resize( op::bv_zext, 16 ); resize( op::bv_zext, 32 );
+            resize( op::bv_trunc, 8 );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1, op::var_i8 ); } ) );
+        }
+
+        TEST( narrow_compare )
+        {
+            var( 1, op::var_i8 ); resize( op::bv_zext, 32 ); c32( 7 ); apply( op::eq );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1, op::var_i8 ); f.c8( 7 ); f.apply( op::eq ); } ) );
+        }
+
+        TEST( narrow_out_of_range )
+        {
+            var( 1, op::var_i8 ); resize( op::bv_zext, 32 ); c32( 300 ); apply( op::bv_ult );
+            s.run( expr );
+            ASSERT( s.constant() );
+            ASSERT( s.value() );
+        }
+
+        TEST( negate_compare )
+        {
+            var( 1 ); c32( 4 ); apply( op::bv_ult ); apply( op::bool_not );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1 ); f.c32( 4 ); f.apply( op::bv_uge ); } ) );
+        }
+
+        TEST( const_left )
+        {
+            c32( 4 ); var( 1 ); apply( op::bv_slt );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1 ); f.c32( 4 ); f.apply( op::bv_sgt ); } ) );
+        }
+
+        TEST( bool_identity )
+        {
+            var( 1 ); c32( 4 ); apply( op::eq );
+            b( true ); apply( op::bool_and );
+            b( false ); apply( op::bool_or );
+            ASSERT( run() == other( []( auto &f ) { f.var( 1 ); f.c32( 4 ); f.apply( op::eq ); } ) );
+        }
+
+        TEST( idempotent )
+        {
+            var( 1, op::var_i8 ); resize( op::bv_sext, 32 ); c32( 0xfffffff0 ); apply( op::bv_sgt );
+            var( 2 ); var( 1, op::var_i8 ); resize( op::bv_zext, 32 ); apply( op::bv_add );
+            c32( 10 ); apply( op::bv_ult );
+            apply( op::bool_and );
+            auto once = run();
+            ASSERT( s.run( once ) == once );
+        }
+
+        TEST( unsupported )
+        {
+            var( 1 ); apply( op::bv_add ); /* malformed: missing operand */
+            ASSERT( run() == expr );
+            ASSERT( unknown() );
+        }
+
+        TEST( decide_unsat )
+        {
+            range( 1, 10, 20 );
+            range( 1, 30, 40 );
+            apply( op::bool_and );
+            run();
+            ASSERT( unsat() );
+        }
+
+        TEST( decide_sat )
+        {
+            range( 1, 10, 20 );
+            var( 1 ); c32( 10 ); apply( op::neq );
+            apply( op::bool_and );
+            range( 2, 0, 1 );
+            apply( op::bool_and );
+            run();
+            ASSERT( sat() );
+        }
+
+        TEST( decide_excluded )
+        {
+            range( 1, 10, 12 );
+            var( 1 ); c32( 10 ); apply( op::neq ); apply( op::bool_and );
+            var( 1 ); c32( 11 ); apply( op::neq ); apply( op::bool_and );
+            run();
+            ASSERT( unsat() );
+        }
+
+        TEST( decide_signed )
+        {
+            var( 1 ); c32( 0xfffffffb ); apply( op::bv_sgt ); /* x > -5 */
+            var( 1 ); c32( 3 ); apply( op::bv_ugt );          /* x > 3 unsigned */
+            apply( op::bool_and );
+            var( 1 ); c32( 100 ); apply( op::bv_sle );
+            apply( op::bool_and );
+            run();
+            ASSERT( sat() );
+        }
+
+        TEST( decide_unknown )
+        {
+            range( 1, 10, 20 );
+            var( 1 ); var( 2 ); apply( op::bv_add ); c32( 3 ); apply( op::bv_ult );
+            apply( op::bool_and );
+            run();
+            ASSERT( unknown() );
+        }
+
+        TEST( decide_unsat_partial )
+        {
+            range( 1, 10, 20 );
+            var( 1 ); var( 2 ); apply( op::bv_add ); c32( 3 ); apply( op::bv_ult );
+            apply( op::bool_and );
+            var( 1 ); c32( 5 ); apply( op::eq );
+            apply( op::bool_and );
+            run();
+            ASSERT( unsat() );
+        }
+    };
+}
+
+#ifdef BRICK_BENCHMARK_REG
+
+#include <random>
+#include <brick-benchmark>
+
+namespace divine::b_smt
+{
+    using namespace divine::smt;
+    using namespace ::brick::benchmark;
+
+    /* Path conditions of a typical loop-bounded program: each step adds a
+     * bound on a fresh or existing variable, with the usual resize noise
+     * coming from the frontend. The x axis is the number of conjuncts. */
+
+    struct simplify : Group, t_smt::formula
+    {
+        std::vector< expr_t > _corpus;
+
+        simplify()
+        {
+            x.type = Axis::Quantitative;
+            x.name = "conjuncts";
+            x.unit = "clause";
+            x.min = 4;
+            x.max = 64;
+            x.log = true;
+            x.step = 2;
+
+            y.type = Axis::Disabled;
+        }
+
+        std::string describe() { return "category:smt category:simplify"; }
+
+        void setup( int _p, int _q ) override
+        {
+            Group::setup( _p, _q );
+            std::mt19937 rand( p );
+            _corpus.clear();
+
+            for ( int i = 0; i < 200; ++i )
+            {
+                expr.clear();
+                for ( int j = 0; j < p; ++j )
+                {
+                    int v = 1 + rand() % 8;
+                    var( v, op::var_i8 );
+                    resize( op::bv_zext, 32 );
+                    c32( rand() % 256 );
+                    apply( rand() % 2 ? op::bv_ult : op::bv_uge );
+                    if ( j )
+                        apply( op::bool_and );
+                }
+                _corpus.push_back( expr );
+            }
+        }
+
+        BENCHMARK( run )
+        {
+            Simplify s;
+            for ( auto &e : _corpus )
+                s.run( e ), s.decide();
+        }
+    };
+}
+
+#endif
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
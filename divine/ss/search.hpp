@@ -5,6 +5,8 @@
 #include <future>
 #include <vector>
 #include <stack>
+#include <deque>
+#include <mutex>
 
 #include <brick-shmem>
 
@@ -26,7 +28,7 @@ struct Job
     std::function< int64_t() > qsize;
 };
 
-enum class Order { PseudoBFS, DFS };
+enum class Order { PseudoBFS, BFS, DFS };
 
 template< typename B, typename L >
 struct Search : Job
@@ -160,6 +162,82 @@ struct Search : Job
         };
     }
 
+    /* A level-synchronous BFS: all states at distance d from the initial
+     * states are expanded (by all the threads) before any state at distance
+     * d + 1. Hence the edge through which a state is first reached (i.e. the
+     * one reported with isnew set) lies on one of its shortest paths. The
+     * last thread to finish a level swaps the frontiers, and the others wait
+     * for it on a barrier. */
+    Worker BFS()
+    {
+        struct Level
+        {
+            std::vector< State > current, next;
+            std::mutex next_mutex;
+            std::atomic< size_t > index{ 0 };
+            std::atomic< int > arrived{ 0 };
+            std::atomic< int64_t > queued{ 0 };
+            bool done = false;
+        };
+
+        auto level = std::make_shared< Level >();
+        shmem::StartDetector barrier;
+
+        qsize = [=]() { return level->queued.load(); };
+
+        auto builder = _builder;
+        auto listener = _listener;
+
+        _initials( listener, builder,
+                   [&]( auto st ) { level->current.push_back( st ), ++ level->queued; } );
+        level->done = level->current.empty();
+
+        return [=]() mutable
+        {
+            auto _reg = _register( builder, listener );
+            barrier.waitForAll( _thread_count );
+            brick::types::Defer _( [&]() { _terminate->store( true ); } );
+            std::vector< State > found;
+
+            while ( !level->done )
+            {
+                try {
+                    for ( size_t i = level->index++; i < level->current.size(); i = level->index++ )
+                    {
+                        if ( _terminate->load() )
+                            break;
+                        _succs( listener, builder, level->current[ i ],
+                                [&]( auto s, auto, bool isnew )
+                                {
+                                    _state( listener, s, isnew,
+                                            [&]( bool ) { found.push_back( s ), ++ level->queued; } );
+                                } );
+                        -- level->queued;
+                    }
+                } catch ( Terminate ) {}
+
+                {
+                    std::lock_guard< std::mutex > _lock( level->next_mutex );
+                    level->next.insert( level->next.end(), found.begin(), found.end() );
+                    found.clear();
+                }
+
+                /* the threads must all leave the loop together, even when
+                 * the search is terminated in the middle of a level */
+                if ( ++ level->arrived == _thread_count )
+                {
+                    level->current.swap( level->next );
+                    level->next.clear();
+                    level->index = 0;
+                    level->arrived = 0;
+                    level->done = level->current.empty() || _terminate->load();
+                }
+
+                barrier.waitForAll( _thread_count );
+            }
+        };
+    }
+
     struct DFSItem
     {
         enum Type { Pre, Post } type;
@@ -210,11 +288,23 @@ struct Search : Job
         switch ( _order )
         {
             case Order::PseudoBFS: blueprint = pseudoBFS(); break;
+            case Order::BFS: blueprint = BFS(); break;
             case Order::DFS: blueprint = DFS(); break;
         }
 
+        /* workers of a search that needs more than one NUMA node are pinned
+         * to the nodes, so that the memory they allocate (which is most of
+         * what they touch) stays local; smaller searches are left to the
+         * scheduler (see numa::spans) */
+        bool pin = shmem::numa::spans( _thread_count );
         for ( int i = 0; i < _thread_count; ++i )
-            _threads.emplace_back( std::async( blueprint ) );
+            _threads.emplace_back( std::async( std::launch::async,
+                                               [ work = blueprint, node = pin ? shmem::numa::place( i ) : -1 ]() mutable
+                                               {
+                                                   if ( node >= 0 )
+                                                       shmem::numa::pin( node );
+                                                   work();
+                                               } ) );
     }
 
     void wait() override
@@ -320,6 +410,62 @@ struct Search
         _random( ss::Order::PseudoBFS, 3 );
     }
 
+    TEST( lbfs_fixed ) { _fixed( ss::Order::BFS, 1 ); }
+    TEST( lbfs_random ) { _random( ss::Order::BFS, 1 ); }
+
+    TEST( lbfs_fixed_parallel )
+    {
+        _fixed( ss::Order::BFS, 2 );
+        _fixed( ss::Order::BFS, 3 );
+    }
+
+    TEST( lbfs_random_parallel )
+    {
+        _random( ss::Order::BFS, 2 );
+        _random( ss::Order::BFS, 3 );
+    }
+
+    void _shortest( int threads )
+    {
+        /* a chain with a shortcut from each 10th state 5 states ahead */
+        std::vector< std::pair< int, int > > vec;
+        for ( int i = 1; i <= 200; ++i )
+        {
+            vec.emplace_back( i, i + 1 );
+            if ( i % 10 == 0 )
+                vec.emplace_back( i, i + 5 );
+        }
+
+        std::vector< int > dist( 202, -1 );
+        std::deque< int > todo{ 1 };
+        dist[ 1 ] = 0;
+        while ( !todo.empty() )
+        {
+            int v = todo.front();
+            todo.pop_front();
+            for ( auto [ f, t ] : vec )
+                if ( f == v && dist[ t ] < 0 )
+                    dist[ t ] = dist[ v ] + 1, todo.push_back( t );
+        }
+
+        std::mutex mutex;
+        std::vector< int > depth( 202, -1 );
+        depth[ 1 ] = 0;
+        ss::search( ss::Order::BFS, ss::Fixed( vec ), threads, ss::passive_listen(
+                        [&]( auto f, auto t, auto, bool isnew )
+                        {
+                            std::lock_guard< std::mutex > _lock( mutex );
+                            if ( isnew )
+                                depth[ t ] = depth[ f ] + 1;
+                        } ) );
+
+        for ( int i = 1; i <= 201; ++i )
+            ASSERT_EQ( depth[ i ], dist[ i ] );
+    }
+
+    TEST( lbfs_shortest ) { _shortest( 1 ); }
+    TEST( lbfs_shortest_parallel ) { _shortest( 2 ); _shortest( 4 ); }
+
     TEST( sequence )
     {
         std::vector< std::pair< int, int > > vec;
@@ -349,6 +349,12 @@ void with_bc::setup()
     if ( _bc_opts.dios_config.empty() )
         _bc_opts.dios_config = "default";
 
+    if ( _cache_dir )
+    {
+        _cc_driver.opts.cache_dir = brq::join_path( _cache_dir.name, "tu" );
+        _cc_driver.opts.build = version();
+    }
+
     _bc = mc::BitCode::with_options( _bc_opts, _cc_driver );
 }
 
@@ -356,6 +362,9 @@ void with_bc::init()
 {
     ASSERT( !_init_done );
 
+    if ( _cache_dir )
+        _bc->use_cache( _cache_dir.name, version() );
+
     _log->loader( Phase::DiOS );
     _bc->do_dios();
 
@@ -397,14 +406,15 @@ void cc::run()
         for ( auto path : po.allowedPaths )
             _driver.addDirectory( path );
 
+        std::vector< cc_ns::File > files;
         for( auto file : po.files )
-        {
-            if ( !file.is< cc_ns::File >() )
-                continue;
-            auto f = file.get< cc_ns::File >();
-            auto m = _driver.compile( f.name, f.type, po.opts );
-            _driver.writeToFile( _output.empty() ? outputName( f.name, "bc" ) : _output, m.get() );
-        }
+            if ( file.is< cc_ns::File >() )
+                files.push_back( file.get< cc_ns::File >() );
+
+        auto mods = _driver.compile_all( files, po.opts );
+        for ( size_t i = 0; i < files.size(); ++i )
+            _driver.writeToFile( _output.empty() ? outputName( files[ i ].name, "bc" ) : _output,
+                                 mods[ i ].get() );
     }
     else
     {
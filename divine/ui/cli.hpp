@@ -191,6 +191,7 @@ namespace divine::ui
         bool _init_done = false;
         SinkPtr _log = nullsink();
         std::string _dump_bc;
+        brq::cmd_path _cache_dir;
         rt::DiosCC _cc_driver;
 
         virtual void process_options();
@@ -229,6 +230,8 @@ namespace divine::ui
             c.section( "Bitcode Transforms" );
             c.flag( "--static-reduction", _bc_opts.static_reduction )
                  << "transform for smaller state space [default: yes]";
+            c.opt( "--cache-dir", _cache_dir )
+                 << "keep the transformed bitcode in this directory for use by later runs";
             c.opt( "--autotrace",      _bc_opts.autotrace ) << "trace function calls";
             c.opt( "--leakcheck",      _bc_opts.leakcheck ) << "insert memory leak checks";
             c.opt( "--sequential",     _bc_opts.sequential ) << "disable support for threading";
@@ -299,10 +302,12 @@ namespace divine::ui
         arg::mem _max_mem = 0; // bytes
         int _max_time = 0;  // seconds
         int _threads = 0;
-        int _poolstat_period = 0;
-        brq::cmd_flag _liveness;
-        bool _interactive = true;
+        int _poolstat_period = 0, _metrics_period = 5, _profile_period = 10000;
+        brq::cmd_flag _liveness, _subsumption, _shortest_ce, _no_pin;
+        bool _interactive = true, _fair = false;
         std::string _solver = "stp";
+        std::string _ltl, _metrics;
+        brq::cmd_path _smt_corpus, _profile;
 
         void setup() override;
         void run() override;
@@ -310,6 +315,7 @@ namespace divine::ui
         void safety();
         void liveness();
         void print_ce( mc::Job &job );
+        void write_profile();
 
         std::string_view help() override
         {
@@ -333,10 +339,28 @@ namespace divine::ui
             with_report::options( c );
             c.section( "Verification Options" );
             c.opt( "--threads", _threads ) << "number of worker threads to use";
+            c.opt( "--no-pin", _no_pin ) << "do not pin the worker threads to NUMA nodes";
             c.opt( "--max-memory", _max_mem ) << "set a memory limit";
             c.opt( "--max-time", _max_time ) << "set a time limit (in seconds)";
-            c.opt( "--liveness", _liveness ) << "enable verification of liveness properties";
+            c.opt( "--liveness", _liveness )
+                << "enable verification of liveness properties (under weak fairness, unless a\n"
+                   "specific --dios-config is given)";
+            c.opt( "--ltl", _ltl ) << "check an LTL property over global variables (implies --liveness)";
             c.opt( "--solver", _solver ) << "select a constraint solver to use in --symbolic mode";
+            c.opt( "--subsumption", _subsumption )
+                << "in --symbolic mode, skip states covered by an already visited one";
+            c.opt( "--smt-corpus", _smt_corpus ) << "record all solver queries into a file";
+            c.opt( "--shortest-ce", _shortest_ce )
+                << "use a (slower) level-synchronous search to find a shortest counterexample";
+            c.opt( "--metrics", _metrics )
+                << "stream search statistics as JSON lines into a file (or unix:/socket/path)";
+            c.opt( "--metrics-period", _metrics_period )
+                << "seconds between two entries of the --metrics stream [5]";
+            c.opt( "--profile", _profile )
+                << "sample the call stacks of the program during the search and write them into a\n"
+                   "file, as folded stacks (the input format of flamegraph.pl)";
+            c.opt( "--profile-period", _profile_period )
+                << "the number of instructions between two --profile samples [10000]";
 
         }
     };
@@ -463,11 +487,69 @@ namespace divine::ui
             c.opt( "-c", _opts.dont_link ) << "compile but do not link";
             c.opt( "--dont-link", _opts.dont_link ) << "alias for the above";
             c.opt( "-o", _output ) << "write the output into a given file";
+            c.opt( "--jobs", _opts.jobs ) << "compile this many files in parallel [one per CPU]";
             c.opt( "-C,", _passthrough ) << "pass additional options to the compiler";
             c.collect( _flags );
         }
     };
 
+    struct serve : command
+    {
+        brq::cmd_path _socket, _cache_dir;
+        int _threads = 0;
+        std::vector< std::string > _preload;
+
+        void run() override;
+
+        std::string_view help() override
+        {
+            return "Keep a DIVINE process running and execute 'verify' and 'check' jobs submitted\n"
+                   "over a UNIX socket (e.g. using 'divine submit'). This saves the start-up cost\n"
+                   "(process start, LLVM initialisation and loading of the DiOS runtime) of each\n"
+                   "job, which is useful when a large number of short jobs is needed, e.g. in\n"
+                   "continuous integration.\n\n"
+                   "Each job runs in a separate process, forked from the server, in the working\n"
+                   "directory of the client. Jobs run concurrently, as long as the sum of their\n"
+                   "--threads fits into the thread budget of the server (jobs which do not give\n"
+                   "--threads use a single thread); the other jobs wait in a queue.";
+        }
+
+        void options( brq::cmd_options &c ) override
+        {
+            command::options( c );
+            c.opt( "--socket", _socket ) << "the path of the socket to listen on";
+            c.opt( "--threads", _threads ) << "the thread budget for all running jobs [all cores]";
+            c.opt( "--cache-dir", _cache_dir )
+                << "the --cache-dir of jobs which do not specify their own";
+            c.opt( "--preload", _preload )
+                << "link this DiOS configuration at start-up (can be repeated) [default]";
+        }
+    };
+
+    struct submit : command
+    {
+        brq::cmd_path _socket;
+        std::string _command;
+        std::vector< std::string > _args;
+
+        void run() override;
+
+        std::string_view help() override
+        {
+            return "Submit a job to a running 'divine serve', wait for it to finish and print its\n"
+                   "output, e.g. 'divine submit --socket /tmp/divine.sock check program.c'. The\n"
+                   "exit code is that of the job.";
+        }
+
+        void options( brq::cmd_options &c ) override
+        {
+            command::options( c );
+            c.opt( "--socket", _socket ) << "the path of the server socket";
+            c.pos( _command, true ); /* the options that follow belong to the job */
+            c.collect( _args );
+        }
+    };
+
     struct info : exec
     {
         info()
@@ -0,0 +1,122 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <divine/ui/governor.hpp>
+#include <divine/mc/job.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace divine::ui
+{
+    namespace
+    {
+        constexpr double stop_fraction = 0.9; /* of the budget */
+        constexpr double space_fraction = 0.97; /* of the address space under --max-memory */
+        constexpr double horizon = 4;         /* seconds to plan the state table for */
+        constexpr uint64_t thread_reserve = 128ull << 20;
+
+        std::string mib( uint64_t bytes ) { return std::to_string( bytes >> 20 ) + " MiB"; }
+    }
+
+    Governor::Governor( SysInfo &si, uint64_t limit )
+        : _sysinfo( si ), _limited( limit ), _budget( limit ? limit : si.memory() * 1024 ),
+          _last_time( Clock::now() )
+    {}
+
+    int Governor::threads() const
+    {
+        /* the workers allocate from node-local memory and the state table is
+         * interleaved across the NUMA nodes (cf. ss::Search), hence all the
+         * cores can be put to use */
+        int rv = std::max( 1u, std::thread::hardware_concurrency() );
+
+        /* each worker needs memory of its own (the heap of the state being
+         * expanded, a malloc arena, stacks): keep most of the budget for the
+         * state space */
+        if ( _budget )
+            rv = std::min< uint64_t >( rv, std::max< uint64_t >( 1, _budget / 4 / thread_reserve ) );
+
+        return rv;
+    }
+
+    Governor::Action Governor::sample( mc::Job &job )
+    {
+        return sample( job, Clock::now(), _sysinfo.residentMemSize() * 1024, _sysinfo.vmSize() * 1024 );
+    }
+
+    Governor::Action Governor::sample( mc::Job &job, Clock::time_point now,
+                                       uint64_t mem, uint64_t virt )
+    {
+        if ( stopped() )
+            return Stop;
+
+        int64_t states = job.stats().first;
+        double dt = std::chrono::duration< double >( now - _last_time ).count();
+
+        if ( dt > 0 )
+        {
+            double rate = std::max( 0.0, ( states - _last_states ) / dt );
+            _rate = _rate ? ( _rate + rate ) / 2 : rate;
+        }
+
+        _last_time = now;
+        _last_states = states;
+
+        uint64_t soft = _budget * stop_fraction, space = _budget * space_fraction;
+
+        if ( _budget && mem >= soft )
+        {
+            _reason = "memory budget exhausted (" + mib( mem ) + " of " + mib( _budget ) + " in use)";
+            return Stop;
+        }
+
+        if ( _limited && virt >= space )
+        {
+            _reason = "address space exhausted (" + mib( virt ) + " of " + mib( _budget ) + " in use)";
+            return Stop;
+        }
+
+        auto [ capacity, cell ] = job.table();
+        int64_t expect = states + _rate * horizon;
+
+        if ( !capacity || expect <= capacity / 2 )
+            return Continue;
+
+        /* the old table is only released after everything is rehashed into
+         * the new one, hence the latter must fit in on top of what is used */
+        int64_t want = capacity;
+        while ( want / 2 < expect )
+            want *= 2;
+
+        uint64_t grow = want * cell;
+
+        if ( !_budget || ( mem + grow <= soft && ( !_limited || virt + grow <= space ) ) )
+            job.reserve( want );
+        else if ( expect >= capacity * 3 / 4 && mem + 2 * capacity * cell > _budget )
+        {
+            _reason = "the state table cannot grow beyond " + std::to_string( capacity ) +
+                      " cells within the memory budget (" + mib( _budget ) + ")";
+            return Stop;
+        }
+
+        return Continue;
+    }
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -0,0 +1,88 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/ui/sysinfo.hpp>
+#include <divine/mc/types.hpp>
+#include <chrono>
+#include <string>
+
+namespace divine::mc { struct Job; }
+
+namespace divine::ui
+{
+    /* The governor ties the resources used by a search to a memory budget:
+     * the --max-memory limit if there is one, the physical memory otherwise.
+     * Before the search starts, it picks the number of worker threads. While
+     * the search is running, it is fed samples by the progress monitor (twice
+     * a second) and it:
+     *
+     *  - extrapolates the growth of the state space from the recent samples
+     *    and grows the state table ahead of time, as long as the bigger table
+     *    fits into the budget,
+     *  - asks for the search to stop once the memory in use gets close to the
+     *    budget, or when the state table is about to grow and the new table
+     *    would not fit; the search then ends with an inconclusive result,
+     *    instead of failing on an allocation somewhere in the middle.
+     *
+     * The memory in use is the resident size of the process: the virtual size
+     * also counts address space that is reserved but never touched (thread
+     * stacks, malloc arenas), which would stop the search early. With
+     * --max-memory, however, the kernel enforces the limit on the virtual
+     * size (see SysInfo::setMemoryLimitInBytes), hence the governor also
+     * stops the search when that is about to run out, and only grows the
+     * state table if the new one fits into the address space as well. */
+
+    struct Governor
+    {
+        enum Action { Continue, Stop };
+        using Clock = std::chrono::steady_clock;
+
+        Governor( SysInfo &si, uint64_t limit );
+
+        int threads() const;
+        Action sample( mc::Job &job );
+
+        /* the above, with the time and the (resident and virtual) memory use
+         * given explicitly instead of measured */
+        Action sample( mc::Job &job, Clock::time_point now, uint64_t resident, uint64_t virt );
+
+        bool stopped() const { return !_reason.empty(); }
+
+        /* a search that was stopped without finding an error is inconclusive */
+        mc::Result result( mc::Result r ) const
+        {
+            return r == mc::Result::Valid && stopped() ? mc::Result::None : r;
+        }
+
+        std::string reason() const { return _reason; }
+
+    private:
+        SysInfo &_sysinfo;
+        bool _limited;
+        uint64_t _budget;
+
+        Clock::time_point _last_time;
+        int64_t _last_states = 0;
+        double _rate = 0; /* states per second, smoothed */
+        std::string _reason;
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
@@ -24,6 +24,12 @@
 #include <divine/mc/types.hpp>
 #include <divine/smt/solver.hpp>
 
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+
 using namespace std::literals;
 
 namespace divine::ui
@@ -252,6 +258,148 @@ struct InteractiveSink : TimedSink
     }
 };
 
+/* Write a snapshot of the search (see mc::Metrics) as a single-line JSON
+ * object each time one is available, so that long runs can be watched (and
+ * plotted) by other programs. The rates are computed over the interval since
+ * the previous snapshot, while the solver latency histograms are cumulative,
+ * given as [ log2( cycles ), count ] pairs for the non-empty buckets. If the
+ * reader on the other end of a socket goes away, the stream is silently shut
+ * down: it should never interfere with the verification itself. */
+struct MetricsSink : LogSink
+{
+    int _fd = -1;
+    bool _socket = false;
+    Clock::time_point _start = Clock::now(), _prev = _start;
+    std::pair< int64_t, int64_t > _total{ 0, 0 };
+    mc::ThreadStats _threads;
+
+    MetricsSink( std::string target )
+    {
+        if ( brq::starts_with( target, "unix:" ) )
+        {
+            std::string path = target.substr( 5 );
+            sockaddr_un addr;
+            addr.sun_family = AF_UNIX;
+            if ( path.size() >= sizeof( addr.sun_path ) )
+                brq::raise() << "the socket path " << path << " is too long";
+            std::strcpy( addr.sun_path, path.c_str() );
+
+            _socket = true;
+            _fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+            if ( _fd >= 0 && ::connect( _fd, reinterpret_cast< sockaddr * >( &addr ),
+                                        sizeof( addr ) ) < 0 )
+                ::close( _fd ), _fd = -1;
+        }
+        else
+            _fd = ::open( target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666 );
+
+        if ( _fd < 0 )
+            brq::raise() << "could not open the metrics stream " << target << ": "
+                         << std::strerror( errno );
+    }
+
+    ~MetricsSink() { if ( _fd >= 0 ) ::close( _fd ); }
+
+    void emit( std::string line )
+    {
+        size_t done = 0;
+
+        while ( _fd >= 0 && done < line.size() )
+        {
+            auto data = line.data() + done;
+            auto r = _socket ? ::send( _fd, data, line.size() - done, MSG_NOSIGNAL )
+                             : ::write( _fd, data, line.size() - done );
+            if ( r < 0 && errno == EINTR )
+                continue;
+            if ( r <= 0 )
+                ::close( _fd ), _fd = -1;
+            else
+                done += r;
+        }
+    }
+
+    template< typename latency >
+    void histogram( std::ostream &o, std::string name )
+    {
+        auto buckets = latency::read();
+        bool first = true;
+
+        o << "\"" << name << "\": [";
+        for ( int i = 0; i < latency::buckets; ++i )
+            if ( buckets[ i ] )
+                o << ( first ? "" : ", " ) << "[" << i << ", " << buckets[ i ] << "]", first = false;
+        o << "]";
+    }
+
+    void metrics( const mc::Metrics &m, bool last ) override
+    {
+        auto now = Clock::now();
+        double span = std::chrono::duration< double >( now - _prev ).count();
+        auto rate = [&]( int64_t v, int64_t prev ) { return span > 0 ? ( v - prev ) / span : 0; };
+        auto sep = [&]( auto &o, bool &first ) { o << ( first ? "" : ", " ); first = false; };
+        std::stringstream o;
+        bool first;
+
+        o << std::fixed << std::setprecision( 3 )
+          << "{ \"time\": " << std::chrono::duration< double >( now - _start ).count()
+          << ", \"last\": " << ( last ? "true" : "false" )
+          << ", \"states\": " << m.total.first << ", \"instructions\": " << m.total.second
+          << ", \"states/s\": " << rate( m.total.first, _total.first )
+          << ", \"instructions/s\": " << rate( m.total.second, _total.second )
+          << ", \"queued\": " << m.queued << ", \"threads\": [";
+
+        for ( size_t i = 0; i < m.threads.size(); ++i )
+        {
+            auto [ st, ins ] = m.threads[ i ];
+            auto [ prev_st, prev_ins ] = i < _threads.size() ? _threads[ i ] : mc::ThreadStats::value_type();
+            o << ( i ? ", " : "" ) << "{ \"states\": " << st << ", \"instructions\": " << ins
+              << ", \"states/s\": " << rate( st, prev_st )
+              << ", \"instructions/s\": " << rate( ins, prev_ins ) << " }";
+        }
+
+        o << "], \"tables\": { ";
+        first = true;
+        for ( auto &[ name, ht ] : m.tables )
+        {
+            sep( o, first );
+            o << "\"" << name << "\": { \"used\": " << ht.used << ", \"capacity\": " << ht.capacity
+              << ", \"load\": " << ( ht.capacity ? double( ht.used ) / ht.capacity : 0 )
+              << ", \"runs\": " << ht.runs
+              << ", \"mean run\": " << ( ht.runs ? double( ht.used ) / ht.runs : 0 )
+              << ", \"longest run\": " << ht.longest_run << " }";
+        }
+
+        o << " }, \"pools\": { ";
+        first = true;
+        for ( auto &[ name, pool ] : m.pools )
+        {
+            sep( o, first );
+            o << "\"" << name << "\": { \"used\": " << pool.total.bytes.used
+              << ", \"held\": " << pool.total.bytes.held << ", \"classes\": [";
+            bool first_class = true;
+            for ( auto c : pool )
+                if ( c.count.held )
+                {
+                    sep( o, first_class );
+                    o << "{ \"size\": " << c.size << ", \"items\": " << c.count.used
+                      << ", \"used\": " << c.bytes.used << ", \"held\": " << c.bytes.held << " }";
+                }
+            o << "] }";
+        }
+
+        o << " }, \"smt\": { ";
+        histogram< smt::feasibility_latency >( o, "feasibility" );
+        o << ", ";
+        histogram< smt::equality_latency >( o, "equality" );
+        o << " } }" << std::endl;
+
+        emit( o.str() );
+        _prev = now;
+        _total = m.total;
+        _threads = m.threads;
+    }
+};
+
 struct NullSink : LogSink {};
 
 SinkPtr nullsink()
@@ -271,6 +419,11 @@ SinkPtr make_interactive()
         return std::make_shared< InteractiveSink >( 60000ms, false );
 }
 
+SinkPtr make_metrics( std::string target )
+{
+    return std::make_shared< MetricsSink >( target );
+}
+
 SinkPtr make_composite( std::vector< SinkPtr > s )
 {
     auto rv = std::make_shared< CompositeSink >();
@@ -35,6 +35,7 @@ struct LogSink
 {
     virtual void progress( std::pair< int64_t, int64_t >, int, bool ) {}
     virtual void memory( const mc::PoolStats &, const mc::HashStats &, bool ) {}
+    virtual void metrics( const mc::Metrics &, bool ) {}
     virtual void loader( Phase ) {}
     virtual void info( std::string, bool = false ) {}
     virtual void result( mc::Result, const mc::Trace & ) {}
@@ -50,6 +51,7 @@ SinkPtr nullsink(); /* a global null sink */
 SinkPtr make_interactive();
 SinkPtr make_yaml( std::ostream &output, bool detailed );
 SinkPtr make_composite( std::vector< SinkPtr > );
+SinkPtr make_metrics( std::string target ); /* a file, or unix:/path/to/socket */
 
 template< typename Self >
 struct CompositeMixin : LogSink
@@ -62,6 +64,9 @@ struct CompositeMixin : LogSink
     void memory( const mc::PoolStats &st, const mc::HashStats &hs, bool l ) override
     { self().each( [&]( auto s ) { s->memory( st, hs, l ); } ); }
 
+    void metrics( const mc::Metrics &m, bool l ) override
+    { self().each( [&]( auto s ) { s->metrics( m, l ); } ); }
+
     void backtrace( DbgContext &c, int lim ) override
     { self().each( [&]( auto s ) { s->backtrace( c, lim ); } ); }
 
@@ -40,8 +40,7 @@ namespace ui {
         else if( !_formula.empty() )
         {
             LTLPtr parsedF = LTL::parse( _formula, true );
-            TGBA1 tgba1 = ltlToTGBA1( parsedF, _negate );
-            tgba2 = std::move( tgba1 );
+            tgba2 = ltlToTGBA2( parsedF, _negate );
         }
         else
         {
@@ -52,7 +52,7 @@ struct CLI : Interface
     auto parse()
     {
         return _parser.parse< verify, check, exec, sim, draw, info, cc,
-                              version, ltlc, refine, extra_cmds... >();
+                              version, ltlc, refine, serve, submit, extra_cmds... >();
     }
 
     std::shared_ptr< Interface > resolve() override
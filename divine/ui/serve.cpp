@@ -0,0 +1,363 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <divine/ui/cli.hpp>
+#include <divine/rt/dios-cc.hpp>
+
+#include <brick-fs>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* The protocol of 'divine serve' is as simple as it gets: the client connects,
+ * sends its working directory and then the command line of the job (starting
+ * with the command, i.e. 'verify' or 'check'), each item terminated by a NUL
+ * byte, and an empty item to finish the request. The server then streams back
+ * everything the job prints (to either stdout or stderr), followed by a NUL
+ * byte and the exit code of the job (in decimal) and closes the connection. A
+ * connection that is closed without the exit code means that the job crashed.
+ *
+ * The server itself does not use threads: it polls the listening socket and
+ * the connections whose requests are still arriving, so that a slow client
+ * cannot hold up the others (a request that does not arrive within 10
+ * seconds is refused). Each job runs in a process forked from the server, so
+ * that it inherits everything that has been loaded so far, but can set its
+ * own working directory and standard output, cannot corrupt the server (or
+ * other jobs) and does not share any of the global state of the checker. The thread budget is enforced by the server: a request
+ * that would not fit is queued (the server keeps accepting connections in
+ * the meantime) and started, in the order of arrival, once enough of the
+ * running jobs have finished. */
+
+namespace divine::ui
+{
+
+namespace
+{
+    sockaddr_un socket_addr( std::string path )
+    {
+        sockaddr_un addr;
+        addr.sun_family = AF_UNIX;
+        if ( path.size() >= sizeof( addr.sun_path ) )
+            brq::raise() << "the socket path " << path << " is too long";
+        std::strcpy( addr.sun_path, path.c_str() );
+        return addr;
+    }
+
+    void write_all( int fd, std::string_view data )
+    {
+        while ( !data.empty() )
+        {
+            auto done = ::write( fd, data.data(), data.size() );
+            if ( done < 0 && errno == EINTR )
+                continue;
+            if ( done <= 0 )
+                return; /* the peer went away, nothing to be done */
+            data.remove_prefix( done );
+        }
+    }
+
+    /* a connection whose request is still being read: the server does not
+     * wait for the client, it reads whatever has arrived whenever the socket
+     * becomes readable (see serve::run) */
+    struct incoming
+    {
+        std::string buf;
+        std::vector< std::string > items;
+        std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+
+        /* the request consists of NUL-terminated items up to an empty one;
+         * returns true once that has arrived */
+        bool parse()
+        {
+            for ( size_t end; ( end = buf.find( '\0' ) ) != std::string::npos; buf.erase( 0, end + 1 ) )
+                if ( end )
+                    items.emplace_back( buf, 0, end );
+                else
+                    return true;
+            return false;
+        }
+    };
+
+    /* the number of threads a job is charged for: what it asks for, between 1
+     * and the whole budget; its --threads is set to match (since --threads 0
+     * would otherwise use all the cores) */
+    int job_threads( std::vector< std::string > &args, int budget )
+    {
+        for ( size_t i = 1; i + 1 < args.size(); ++i )
+            if ( args[ i ] == "--threads" )
+            {
+                int n = std::clamp( std::atoi( args[ i + 1 ].c_str() ), 1, budget );
+                args[ i + 1 ] = std::to_string( n );
+                return n;
+            }
+
+        args.insert( args.begin() + 1, { "--threads", "1" } );
+        return 1;
+    }
+
+    struct request
+    {
+        int conn;
+        std::string cwd;
+        std::vector< std::string > args;
+        int threads;
+    };
+}
+
+void serve::run()
+{
+    if ( !_socket )
+        brq::raise() << "serve: --socket is required";
+
+    int budget = _threads ? _threads : std::max( 1u, std::thread::hardware_concurrency() );
+
+    rt::DiosCC::reuse_runtime = true;
+    if ( _preload.empty() )
+        _preload.push_back( "default" );
+    for ( auto cfg : _preload )
+        rt::DiosCC::prelinked_runtime( cfg, "" );
+
+    ::signal( SIGPIPE, SIG_IGN ); /* clients may go away at any time */
+
+    auto addr = socket_addr( _socket.name );
+    int sock = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    ::unlink( _socket.name.c_str() ); /* a stale socket from an earlier run */
+    if ( sock < 0 || ::bind( sock, reinterpret_cast< sockaddr * >( &addr ), sizeof( addr ) ) < 0 ||
+         ::listen( sock, 128 ) < 0 )
+        brq::raise() << "could not listen on " << _socket.name << ": " << std::strerror( errno );
+
+    std::cerr << "serving on " << _socket.name << ", " << budget << " threads" << std::endl;
+
+    std::map< pid_t, int > running; /* pid → threads */
+    std::map< int, incoming > reading; /* connection → what it sent so far */
+    std::deque< request > pending;
+    int used = 0;
+
+    auto reap = [&]
+    {
+        pid_t pid;
+        int status;
+        while ( ( pid = ::waitpid( -1, &status, WNOHANG ) ) > 0 )
+        {
+            used -= running[ pid ];
+            running.erase( pid );
+        }
+    };
+
+    auto start = [&]( request &r )
+    {
+        pid_t pid = ::fork();
+        if ( pid < 0 )
+        {
+            write_all( r.conn, std::string( "ERROR: fork failed\n" ) + '\0' + "1" );
+            ::close( r.conn );
+            return;
+        }
+
+        if ( pid == 0 )
+        {
+            ::signal( SIGPIPE, SIG_DFL ); /* nobody is listening, stop the job */
+            ::close( sock );
+            for ( auto &p : pending )
+                if ( p.conn != r.conn )
+                    ::close( p.conn );
+            for ( auto &c : reading )
+                ::close( c.first );
+            ::dup2( r.conn, 1 );
+            ::dup2( r.conn, 2 );
+            ::close( r.conn );
+
+            int code = 0;
+            try
+            {
+                if ( ::chdir( r.cwd.c_str() ) < 0 )
+                    brq::raise() << "could not change directory to " << r.cwd;
+
+                brq::cmd_parser parser( "divine", r.args );
+                auto cmd = parser.parse< verify, check >();
+                cmd.match( [&]( brq::cmd_help &help ) { help.run(); },
+                           [&]( with_bc &job )
+                           {
+                               if ( !job._cache_dir )
+                                   job._cache_dir = _cache_dir;
+                               job.setup();
+                               job.run();
+                               job.cleanup();
+                           } );
+            }
+            catch ( brq::error &e )
+            {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+                code = e._exit;
+            }
+            catch ( std::exception &e )
+            {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+                code = 1;
+            }
+
+            std::cout.flush();
+            std::cerr.flush();
+            write_all( 1, std::string( 1, '\0' ) + std::to_string( code ) );
+            ::_exit( code );
+        }
+
+        ::close( r.conn );
+        running[ pid ] = r.threads;
+        used += r.threads;
+    };
+
+    while ( true )
+    {
+        reap();
+        while ( !pending.empty() && used + pending.front().threads <= budget )
+        {
+            start( pending.front() );
+            pending.pop_front();
+        }
+
+        auto refuse = [&]( int conn, std::string why )
+        {
+            write_all( conn, "ERROR: " + why + "\n" + '\0' + "1" );
+            ::close( conn );
+            reading.erase( conn );
+        };
+
+        /* do not let a stuck client hold its connection forever */
+        auto now = std::chrono::steady_clock::now();
+        std::vector< int > stuck;
+        for ( auto &[ conn, in ] : reading )
+            if ( now - in.since > std::chrono::seconds( 10 ) )
+                stuck.push_back( conn );
+        for ( int conn : stuck )
+            refuse( conn, "timed out reading the request" );
+
+        std::vector< pollfd > pfds{ { sock, POLLIN, 0 } };
+        for ( auto &c : reading )
+            pfds.push_back( { c.first, POLLIN, 0 } );
+
+        /* a running job may finish at any time, check back every now and then */
+        bool idle = running.empty() && reading.empty();
+        int ready = ::poll( pfds.data(), pfds.size(), idle ? -1 : 100 );
+        if ( ready < 0 && errno != EINTR )
+            brq::raise() << "poll on " << _socket.name << " failed: " << std::strerror( errno );
+        if ( ready <= 0 )
+            continue;
+
+        for ( auto &pfd : pfds )
+        {
+            if ( !pfd.revents || pfd.fd == sock )
+                continue;
+
+            char chunk[ 4096 ];
+            auto got = ::read( pfd.fd, chunk, sizeof( chunk ) );
+            if ( got < 0 && ( errno == EINTR || errno == EAGAIN ) )
+                continue;
+            if ( got <= 0 )
+            {
+                refuse( pfd.fd, "malformed request" );
+                continue;
+            }
+
+            auto &in = reading[ pfd.fd ];
+            in.buf.append( chunk, got );
+            if ( !in.parse() )
+                continue;
+
+            if ( in.items.size() < 2 )
+            {
+                refuse( pfd.fd, "malformed request" );
+                continue;
+            }
+
+            /* the job writes its output into the connection as its stdout */
+            ::fcntl( pfd.fd, F_SETFL, ::fcntl( pfd.fd, F_GETFL ) & ~O_NONBLOCK );
+            std::vector< std::string > args( in.items.begin() + 1, in.items.end() );
+            int threads = job_threads( args, budget );
+            pending.push_back( { pfd.fd, in.items[ 0 ], std::move( args ), threads } );
+            reading.erase( pfd.fd );
+        }
+
+        if ( pfds[ 0 ].revents )
+        {
+            int conn = ::accept4( sock, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK );
+            if ( conn >= 0 )
+                reading[ conn ];
+            else if ( errno != EINTR && errno != ECONNABORTED && errno != EAGAIN )
+                brq::raise() << "accept on " << _socket.name << " failed: " << std::strerror( errno );
+        }
+    }
+}
+
+void submit::run()
+{
+    if ( !_socket )
+        brq::raise() << "submit: --socket is required";
+
+    auto addr = socket_addr( _socket.name );
+    int fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if ( fd < 0 || ::connect( fd, reinterpret_cast< sockaddr * >( &addr ), sizeof( addr ) ) < 0 )
+        brq::raise() << "could not connect to " << _socket.name << ": " << std::strerror( errno );
+
+    std::string req = brq::getcwd() + '\0' + _command + '\0';
+    for ( auto &a : _args )
+        req += a + '\0';
+    write_all( fd, req + '\0' );
+
+    /* everything up to the last NUL is output, the rest is the exit code */
+    std::string tail;
+    char chunk[ 4096 ];
+    ssize_t got;
+
+    while ( ( got = ::read( fd, chunk, sizeof( chunk ) ) ) != 0 )
+    {
+        if ( got < 0 && errno == EINTR )
+            continue;
+        if ( got < 0 )
+            break;
+        tail.append( chunk, got );
+        auto nul = tail.rfind( '\0' );
+        auto keep = nul == std::string::npos ? 0 : tail.size() - nul;
+        std::cout.write( tail.data(), tail.size() - keep );
+        tail.erase( 0, tail.size() - keep );
+    }
+
+    std::cout.flush();
+    ::close( fd );
+
+    if ( tail.empty() )
+        brq::raise() << "the job terminated abnormally";
+    if ( int code = std::atoi( tail.c_str() + 1 ) )
+        std::exit( code );
+}
+
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
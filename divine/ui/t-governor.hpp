@@ -0,0 +1,99 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/ui/governor.hpp>
+#include <divine/mc/job.hpp>
+
+namespace divine::t_ui
+{
+    using namespace std::literals;
+
+    /* a search that is not running: the state count and the state table are
+     * set by the test, and reserve() only remembers what was asked for */
+    struct FakeJob : mc::Job
+    {
+        int64_t states = 0, capacity = 0, cell = 16, reserved = 0;
+
+        FakeJob() { stats = [this] { return std::make_pair( states, int64_t( 0 ) ); }; }
+
+        std::pair< int64_t, int64_t > table() override { return { capacity, cell }; }
+        void reserve( int64_t cells ) override { reserved = cells; }
+        void start( int ) override {}
+    };
+
+    struct TestGovernor
+    {
+        static constexpr uint64_t MiB = 1ull << 20, budget = 1024 * MiB;
+
+        ui::SysInfo sysinfo;
+        ui::Governor gov{ sysinfo, budget };
+        ui::Governor::Clock::time_point t = ui::Governor::Clock::now();
+        FakeJob job;
+
+        auto sample( int64_t states, uint64_t resident, uint64_t virt )
+        {
+            job.states = states;
+            t += 1s;
+            return gov.sample( job, t, resident, virt );
+        }
+
+        TEST( reserve )
+        {
+            job.capacity = 1 << 20;
+            ASSERT_EQ( sample( 100'000, 100 * MiB, 200 * MiB ), ui::Governor::Continue );
+            ASSERT_EQ( job.reserved, 0 ); /* 500k states expected in 4 seconds */
+            ASSERT_EQ( sample( 300'000, 100 * MiB, 200 * MiB ), ui::Governor::Continue );
+            ASSERT_EQ( job.reserved, 2 << 20 ); /* 900k expected, grow ahead of time */
+            ASSERT( !gov.stopped() );
+            ASSERT( gov.result( mc::Result::Valid ) == mc::Result::Valid );
+        }
+
+        TEST( stop_memory )
+        {
+            ASSERT_EQ( sample( 1000, 950 * MiB, 960 * MiB ), ui::Governor::Stop );
+            ASSERT( gov.stopped() );
+            ASSERT( brq::starts_with( gov.reason(), "memory budget exhausted" ) );
+            ASSERT_EQ( sample( 1000, 100 * MiB, 200 * MiB ), ui::Governor::Stop ); /* for good */
+            ASSERT( gov.result( mc::Result::Valid ) == mc::Result::None );
+            ASSERT( gov.result( mc::Result::Error ) == mc::Result::Error );
+        }
+
+        TEST( resident )
+        {
+            /* the virtual size alone does not stop the search, unless the
+             * address space is about to run out */
+            ASSERT_EQ( sample( 1000, 100 * MiB, 950 * MiB ), ui::Governor::Continue );
+            ASSERT( !gov.stopped() );
+            ASSERT_EQ( sample( 1000, 100 * MiB, 1000 * MiB ), ui::Governor::Stop );
+            ASSERT( brq::starts_with( gov.reason(), "address space exhausted" ) );
+        }
+
+        TEST( stop_table )
+        {
+            job.capacity = 32 << 20; /* 512 MiB, a bigger one does not fit */
+            ASSERT_EQ( sample( 25 << 20, 600 * MiB, 700 * MiB ), ui::Governor::Stop );
+            ASSERT_EQ( job.reserved, 0 );
+            ASSERT( brq::starts_with( gov.reason(), "the state table cannot grow" ) );
+            ASSERT( gov.result( mc::Result::Valid ) == mc::Result::None );
+        }
+    };
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
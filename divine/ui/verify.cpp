@@ -20,10 +20,16 @@
 #include <divine/mc/safety.hpp>
 #include <divine/mc/job.tpp>
 #include <divine/mc/trace.hpp>
+#include <divine/mc/product.hpp>
+#include <divine/ltl/ltl.hpp>
+#include <divine/smt/corpus.hpp>
 #include <divine/dbg/stepper.hpp>
 #include <divine/dbg/setup.hpp>
+#include <divine/dbg/print.hpp>
+#include <divine/vm/profile.hpp>
 #include <divine/ui/cli.hpp>
 #include <divine/ui/sysinfo.hpp>
+#include <divine/ui/governor.hpp>
 
 namespace divine {
 namespace ui {
@@ -50,13 +56,41 @@ void verify::setup()
         _log = make_composite( log );
     }
 
-    if ( _bc_opts.dios_config.empty() && _liveness )
-        _bc_opts.dios_config = "fair";
+    if ( !_metrics.empty() )
+        _log = make_composite( { _log, make_metrics( _metrics ) } );
+
+    if ( !_ltl.empty() )
+        _liveness = true;
+
+    /* fairness is checked by the search, with the plain scheduler, unless a
+     * particular DiOS config (such as 'fair') is requested */
+    _fair = _liveness && _bc_opts.dios_config.empty() && !_bc_opts.synchronous;
 
     with_bc::setup();
 
     if ( _bc_opts.symbolic )
         bitcode()->solver( _solver );
+
+    if ( _subsumption )
+    {
+        if ( !_bc_opts.symbolic )
+            brq::raise() << "--subsumption only makes sense with --symbolic";
+        if ( _liveness )
+            brq::raise() << "--subsumption cannot be combined with --liveness";
+        bitcode()->subsumption( true );
+    }
+
+    if ( _shortest_ce && _liveness )
+        brq::raise() << "--shortest-ce cannot be combined with --liveness";
+
+    if ( !_ltl.empty() ) /* an automaton for the negation, i.e. for the counterexamples */
+    {
+        ltl::TGBA2 tgba = ltl::ltlToTGBA2( ltl::LTL::parse( _ltl ), true );
+        bitcode()->automaton( std::make_shared< mc::Automaton >( tgba ) );
+    }
+
+    if ( _smt_corpus )
+        smt::corpus::open( _smt_corpus.name );
 }
 
 void check::setup()
@@ -67,12 +101,52 @@ void check::setup()
 
 void verify::run()
 {
+    brick::shmem::numa::pinning = !_no_pin;
+
+    if ( _profile )
+    {
+        vm::profile::reset();
+        vm::profile::start( _profile_period );
+    }
+
     if ( _liveness )
         liveness();
     else
         safety();
 }
 
+/* Write the profile as folded stacks: a line per distinct call stack, with
+ * the function names from the outermost to the innermost frame separated by
+ * semicolons, followed by the number of samples. */
+void verify::write_profile()
+{
+    if ( !_profile )
+        return;
+
+    vm::profile::stop(); /* do not include the counterexample replay */
+
+    auto &info = bitcode()->debug();
+    std::map< std::string, int64_t > folded;
+
+    for ( auto &[ stack, count ] : vm::profile::samples() )
+    {
+        std::string line;
+        for ( auto pc = stack.rbegin(); pc != stack.rend(); ++pc )
+        {
+            auto fun = info.function( *pc );
+            line += line.empty() ? "" : ";";
+            line += fun ? info.makePretty( dbg::print::demangle( fun->getName().str() ) ) : "??";
+        }
+        folded[ line ] += count;
+    }
+
+    std::ofstream out( _profile.name );
+    if ( !out )
+        brq::raise() << "could not open " << _profile.name << " for writing";
+    for ( auto &[ line, count ] : folded )
+        out << line << " " << count << std::endl;
+}
+
 void verify::print_ce( mc::Job &job ) try
 {
     dbg::Context< vm::CowHeap > dbg( bitcode()->program(), bitcode()->debug() );
@@ -129,16 +203,18 @@ void verify::safety()
 {
     mc::builder::State error;
 
-    if ( !_threads )
-        _threads = std::min( 4u, std::thread::hardware_concurrency() );
-
     auto safety = mc::make_job< mc::Safety >( bitcode(), ss::passive_listen() );
+    safety->shortest_ce = _shortest_ce;
 
     SysInfo sysinfo;
     sysinfo.setMemoryLimitInBytes( _max_mem.size );
+    Governor governor( sysinfo, _max_mem.size );
+
+    if ( !_threads )
+        _threads = governor.threads();
 
     _log->start();
-    int ps_ctr = 0;
+    int ps_ctr = 0, m_ctr = 0;
 
     safety->start( _threads, [&]( bool last )
                    {
@@ -146,35 +222,57 @@ void verify::safety()
                                        safety->queuesize(), last );
                        if ( last || ( ++ps_ctr == 2 * _poolstat_period ) )
                            ps_ctr = 0, _log->memory( safety->poolstats(), safety->hashstats(), last );
+                       if ( !_metrics.empty() && ( last || ++m_ctr == 2 * _metrics_period ) )
+                           m_ctr = 0, _log->metrics( safety->metrics(), last );
                        if ( !last )
                            sysinfo.updateAndCheckTimeLimit( _max_time );
+                       if ( !last && governor.sample( *safety ) == Governor::Stop )
+                           safety->stop();
                    } );
     safety->wait();
+    write_profile();
     report_options();
     _log->info( "smt solver: " + _solver + "\n", true );
     _log->info( "property type: safety\n", true );
 
-    if ( safety->result() == mc::Result::Valid )
-        return _log->result( safety->result(), mc::Trace() );
+    auto result = governor.result( safety->result() );
+
+    if ( result == mc::Result::None )
+        _log->info( "search incomplete: " + governor.reason() + "\n", false );
+
+    if ( result == mc::Result::None || result == mc::Result::Valid )
+        return _log->result( result, mc::Trace() );
 
     print_ce( *safety );
 }
 
 void verify::liveness()
 {
+    SysInfo sysinfo;
+
+    if ( !_threads )
+        _threads = Governor( sysinfo, _max_mem.size ).threads();
+
     auto liveness = mc::make_job< mc::Liveness >( bitcode(), ss::passive_listen() );
+    liveness->fair = _fair;
 
     _log->start();
-    liveness->start( 1, [&]( bool last )
+    int m_ctr = 0;
+    liveness->start( _threads, [&]( bool last )
                    {
                        _log->progress( liveness->stats(),
                                        liveness->queuesize(), last );
+                       if ( !_metrics.empty() && ( last || ++m_ctr == 2 * _metrics_period ) )
+                           m_ctr = 0, _log->metrics( liveness->metrics(), last );
                    } );
 
     liveness->wait();
+    write_profile();
 
     report_options();
     _log->info( "property type: liveness\n", true );
+    if ( !_ltl.empty() )
+        _log->info( "property: " + _ltl + "\n", true );
 
     print_ce( *liveness );
 }
@@ -26,6 +26,7 @@
 #include <divine/vm/ctx-debug.tpp>
 #include <divine/vm/dispatch.hpp>
 #include <divine/vm/eval-fault.hpp>
+#include <divine/vm/profile.hpp>
 
 #include <divine/vm/divm.h>
 
@@ -435,6 +436,8 @@ public:
             implement_call( false );
     }
 
+    bool _profile = false; /* set at the start of each run, see profile.hpp */
+
     void run();
     bool run_seq( bool continued );
     void dispatch(); /* evaluate a single instruction */
@@ -452,10 +455,37 @@ public:
     {
         ASSERT_EQ( CodePointer( context().pc() ), pc() );
         context().count_instruction();
+        if ( _profile && profile::tick() )
+            sample();
         context().set( _VM_CR_PC, program().nextpc( pc() + 1 ) );
         refresh();
     }
 
+    /* record the call stack for the profiler, see profile.hpp */
+    [[gnu::noinline]] void sample()
+    {
+        if ( context().debug_mode() )
+            return;
+
+        profile::Stack stack{ pc() };
+        GenericPointer fr = frame();
+        PointerV parent, caller;
+        auto live = [&]( auto p ) { return !p.null() && p.heap() && heap().valid( p ); };
+
+        while ( int( stack.size() ) < profile::max_depth && live( fr ) )
+        {
+            heap().read( HeapPointer( fr ) + PointerBytes, parent );
+            if ( !live( fr = parent.cooked() ) )
+                break;
+            heap().read( HeapPointer( fr ), caller );
+            if ( caller.cooked().type() != PointerType::Code )
+                break;
+            stack.push_back( caller.cooked() );
+        }
+
+        profile::record( std::move( stack ) );
+    }
+
     void refresh()
     {
         _instruction = &program().instruction( pc() );
@@ -755,6 +755,7 @@ template< typename Ctx >
 void Eval< Ctx >::run()
 {
     context().reset_interrupted();
+    _profile = profile::enabled() && !context().debug_mode();
     do {
         advance();
         dispatch();
@@ -764,6 +765,8 @@ void Eval< Ctx >::run()
 template< typename Ctx >
 bool Eval< Ctx >::run_seq( bool continued )
 {
+    _profile = profile::enabled() && !context().debug_mode();
+
     if ( continued )
         refresh(), dispatch();
     else
@@ -0,0 +1,92 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include <divine/vm/pointer.hpp>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/* A sampling profiler for the interpreted program. Once every `period`
+ * instructions (as counted by Eval::advance), the evaluator records the call
+ * stack of the executing program: the current pc, followed by the pc of the
+ * call instruction in each of the calling frames. The profile is global (like
+ * brq::timer), collects samples from all evaluator instances in all threads
+ * and it is up to the user to resolve the code pointers into something
+ * readable, e.g. using dbg::Info.
+ *
+ * Whether sampling is on is checked once at the start of each run of the
+ * evaluator, hence when it is off, the per-instruction cost is a test of a
+ * member flag. While it is on, each instruction decrements a thread-local
+ * counter. Runs which start in debug mode are not profiled at all; debug
+ * calls made during a normal run count towards the period, but are never
+ * sampled. */
+
+namespace divine::vm::profile
+{
+    using Stack = std::vector< CodePointer >; /* innermost frame first */
+    using Samples = std::map< Stack, int64_t >;
+
+    constexpr int max_depth = 256;
+    constexpr int64_t idle = 1 << 20; /* how often to check whether to start sampling */
+
+    inline std::atomic< int64_t > period{ 0 };
+    inline thread_local int64_t countdown = 1;
+
+    inline std::mutex _mutex;
+    inline Samples _samples;
+
+    inline void start( int64_t p ) { period = p; }
+    inline void stop() { period = 0; }
+    inline bool enabled() { return period.load( std::memory_order_relaxed ); }
+
+    /* called for each instruction of a profiled run, true if a sample should
+     * be taken now */
+    [[gnu::always_inline]] inline bool tick()
+    {
+        if ( __builtin_expect( --countdown > 0, 1 ) )
+            return false;
+
+        int64_t p = period.load( std::memory_order_relaxed );
+        countdown = p ? p : idle;
+        return p;
+    }
+
+    inline void record( Stack &&stack )
+    {
+        std::lock_guard< std::mutex > _lock( _mutex );
+        ++ _samples[ std::move( stack ) ];
+    }
+
+    inline Samples samples()
+    {
+        std::lock_guard< std::mutex > _lock( _mutex );
+        return _samples;
+    }
+
+    inline void reset()
+    {
+        std::lock_guard< std::mutex > _lock( _mutex );
+        _samples.clear();
+    }
+}
+
+// vim: syntax=cpp tabstop=4 shiftwidth=4 expandtab ft=cpp
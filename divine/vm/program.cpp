@@ -359,7 +359,13 @@ Program::Position Program::insert( Position p )
                 insn.values[ i + 1 ] = insert( p.pc.function(), p.I->getOperand( i ) );
         insn.values[0] = insert( p.pc.function(), &*p.I );
 
-        if ( auto PHI = dyn_cast< llvm::PHINode >( p.I ) )
+        /* The constants below belong to this instruction alone (they are not
+         * in the valuemap), hence they are only allocated in the last of the
+         * layout passes -- otherwise, each pass would leave another copy
+         * behind in the constant heap. */
+        bool last = framealign == 1;
+
+        if ( auto PHI = dyn_cast< llvm::PHINode >( p.I ); PHI && last )
         {
             auto nPHI = dyn_cast< llvm::PHINode >( std::next( p.I ) );
             for ( unsigned idx = 0; idx < PHI->getNumOperands(); ++idx )
@@ -372,10 +378,10 @@ Program::Position Program::insert( Position p )
             }
         }
 
-        if ( isa< llvm::ExtractValueInst >( p.I ) )
+        if ( last && isa< llvm::ExtractValueInst >( p.I ) )
             insertIndices< llvm::ExtractValueInst >( p );
 
-        if ( isa< llvm::InsertValueInst >( p.I ) )
+        if ( last && isa< llvm::InsertValueInst >( p.I ) )
             insertIndices< llvm::InsertValueInst >( p );
     }
 
@@ -154,8 +154,8 @@ struct Program
      * those maps at runtime, hence we cannot clear them after the RR is built.
      * Fixing this is a work in progress. */
 
-    std::map< const llvm::Value *, Slot > valuemap;
-    std::map< const llvm::Value *, Slot > globalmap;
+    std::unordered_map< const llvm::Value *, Slot > valuemap;
+    std::unordered_map< const llvm::Value *, Slot > globalmap;
     std::map< const llvm::Type *, int > typemap;
     std::map< const llvm::Value *, std::string > anonmap;
     std::set< const llvm::Function * > is_debug;
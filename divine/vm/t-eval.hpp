@@ -606,6 +606,26 @@ struct Eval
         ASSERT_EQ( x.cooked(), 18 );
     }
 
+    TEST(profile)
+    {
+        auto p = c2prog( "int g( int x ) { return x * 3; } "
+                         "int f( int a ) { int s = 0; for ( int i = 0; i < a; ++i ) s += g( i ); "
+                         "return s; }" );
+        vm::profile::reset();
+        vm::profile::start( 1 );
+        vm::profile::countdown = 1; /* the period is only checked once in a while */
+        ASSERT_EQ( testP( p, IntV( 10 ) ).cooked(), 135 );
+        vm::profile::stop();
+
+        int f = p->functionByName( "f" ).function(), g = p->functionByName( "g" ).function();
+        bool nested = false;
+        for ( auto &[ stack, count ] : vm::profile::samples() )
+            if ( stack.size() == 2 && stack[ 0 ].function() == g && stack[ 1 ].function() == f )
+                nested = true;
+        vm::profile::reset();
+        ASSERT( nested );
+    }
+
 };
 #endif
 
@@ -13,6 +13,8 @@ DIVINE_UNRELAX_WARNINGS
 #include <brick-llvm>
 #include <string>
 #include <iostream>
+#include <optional>
+#include <set>
 
 #include <lart/support/pass.h>
 #include <lart/support/meta.h>
@@ -39,9 +41,19 @@ struct CflInterrupt
         insert( v, b );
     }
 
-    void annotateFn( llvm::Function &fn )
+    using BackEdges = decltype( getBackEdges( std::declval< llvm::Function & >() ) );
+
+    /* finding the back edges only reads the CFG, hence runs in parallel */
+    BackEdges analyse( llvm::Function &fn )
+    {
+        if ( fn.empty() || _skip.count( &fn ) )
+            return {};
+        return getBackEdges( fn );
+    }
+
+    void transform( llvm::Function &fn, BackEdges backedges )
     {
-        for ( auto b : getBackEdges( fn ) )
+        for ( auto b : backedges )
         {
             auto *src = b.from;
             auto idx = b.succIndex;
@@ -77,10 +89,10 @@ struct CflInterrupt
         }
     }
 
-    void run( llvm::Module &m )
+    bool setup( llvm::Module &m )
     {
         if ( !tagModuleWithMetadata( m, "lart.divine.interrupt.cfl" ) )
-            return;
+            return false;
 
         auto void_t = llvm::Type::getVoidTy( m.getContext() );
         auto i32_t = llvm::Type::getInt32Ty( m.getContext() );
@@ -100,18 +112,15 @@ struct CflInterrupt
         _handler->addFnAttr( llvm::Attribute::NoUnwind );
 
         LowerAnnotations( Interrupt::local_skipcfl ).run( m );
-        auto skip = util::functions_with_attr( Interrupt::local_skipcfl, m );
-
-        for ( auto &fn : m )
-        {
-            if ( fn.empty() || skip.count( &fn ) )
-                continue;
-            annotateFn( fn );
-        }
+        _skip = util::functions_with_attr( Interrupt::local_skipcfl, m );
+        return true;
     }
 
+    void run( llvm::Module &m ) { runFunctionLocal( *this, m ); }
+
     std::string _handler_name;
     llvm::Function *_hypercall, *_handler;
+    std::set< llvm::Function * > _skip;
     long _backedges = 0;
 };
 
@@ -122,53 +131,71 @@ struct MemInterrupt
 
     MemInterrupt( std::string n ) : _handler_name( n ) {}
 
-    void annotateFn( llvm::Function &fn, llvm::DataLayout &dl, unsigned silentID )
+    using Accesses = std::vector< llvm::Instruction * >;
+
+    /* collect the visible memory accesses; this only reads the instructions
+     * (and their metadata) and runs in parallel -- the sizes are computed in
+     * transform, since DataLayout caches struct layouts internally */
+    Accesses analyse( llvm::Function &fn )
+    {
+        Accesses rv;
+        if ( fn.empty() || _skip.count( &fn ) )
+            return rv;
+
+        for ( auto &bb : fn )
+            for ( auto &inst : bb )
+            {
+                auto op = inst.getOpcode();
+                if ( ( op == llvm::Instruction::Load || op == llvm::Instruction::Store ||
+                       op == llvm::Instruction::AtomicRMW ||
+                       op == llvm::Instruction::AtomicCmpXchg ) &&
+                     !reduction::isSilent( inst, _silentID ) )
+                    rv.push_back( &inst );
+            }
+        return rv;
+    }
+
+    void transform( llvm::Function &, Accesses accesses )
     {
-        // avoid changing bb while we iterate over it
-        for ( auto inst : query::query( fn ).flatten().map( query::refToPtr ).freeze() )
+        auto &dl = *_dl;
+        for ( auto inst : accesses )
         {
             auto op = inst->getOpcode();
-            if ( ( op == llvm::Instruction::Load || op == llvm::Instruction::Store ||
-                   op == llvm::Instruction::AtomicRMW ||
-                   op == llvm::Instruction::AtomicCmpXchg ) &&
-                 !reduction::isSilent( *inst, silentID ) )
+            auto *type = _hypercall->getFunctionType();
+            llvm::IRBuilder<> irb{ inst };
+            auto *origPtr = lart::getPointerOperand( inst );
+            auto *origT = llvm::cast< llvm::PointerType >( origPtr->getType() )
+                              ->getElementType();
+            auto *ptr = irb.CreateBitCast( origPtr, type->getParamType( 0 ) );
+            auto *si = irb.getInt32( std::max( uint64_t( 1 ), dl.getTypeSizeInBits( origT ) / 8 ) );
+            int intr_type;
+            switch ( op )
             {
-                auto *type = _hypercall->getFunctionType();
-                llvm::IRBuilder<> irb{ inst };
-                auto *origPtr = lart::getPointerOperand( inst );
-                auto *origT = llvm::cast< llvm::PointerType >( origPtr->getType() )
-                                  ->getElementType();
-                auto *ptr = irb.CreateBitCast( origPtr, type->getParamType( 0 ) );
-                auto *si = irb.getInt32( std::max( uint64_t( 1 ), dl.getTypeSizeInBits( origT ) / 8 ) );
-                int intr_type;
-                switch ( op )
-                {
-                    case llvm::Instruction::Load: intr_type = _VM_MAT_Load; break;
-                    case llvm::Instruction::Store: intr_type = _VM_MAT_Store; break;
-                    default: intr_type = _VM_MAT_Both; break;
-                }
-                auto point = std::next( llvm::BasicBlock::iterator( inst ) );
-
-                if ( auto call = llvm::dyn_cast< llvm::CallInst >( point ) ) {
-                    auto fn = call->getCalledFunction();
-                    if ( fn && fn->getName().startswith( freeze ) )
-                        point = std::next( point );
-                    if ( fn && fn->getName().startswith( thaw ) )
-                        point = std::next( point );
-                }
-
-                irb.SetInsertPoint( &*point );
-                irb.CreateCall( _hypercall, { ptr, si, irb.getInt32( intr_type ), _handler } );
-
-                ++_mem;
+                case llvm::Instruction::Load: intr_type = _VM_MAT_Load; break;
+                case llvm::Instruction::Store: intr_type = _VM_MAT_Store; break;
+                default: intr_type = _VM_MAT_Both; break;
+            }
+            auto point = std::next( llvm::BasicBlock::iterator( inst ) );
+
+            if ( auto call = llvm::dyn_cast< llvm::CallInst >( point ) ) {
+                auto fn = call->getCalledFunction();
+                if ( fn && fn->getName().startswith( freeze ) )
+                    point = std::next( point );
+                if ( fn && fn->getName().startswith( thaw ) )
+                    point = std::next( point );
             }
+
+            irb.SetInsertPoint( &*point );
+            irb.CreateCall( _hypercall, { ptr, si, irb.getInt32( intr_type ), _handler } );
+
+            ++_mem;
         }
     }
 
-    void run( llvm::Module &m )
+    bool setup( llvm::Module &m )
     {
         if ( !tagModuleWithMetadata( m, "lart.divine.interrupt.mem" ) )
-            return;
+            return false;
 
         auto i32_t = llvm::Type::getInt32Ty( m.getContext() );
         auto void_t = llvm::Type::getVoidTy( m.getContext() );
@@ -189,22 +216,21 @@ struct MemInterrupt
         _hypercall->addFnAttr( llvm::Attribute::NoUnwind );
         _handler->addFnAttr( llvm::Attribute::NoUnwind );
 
-        auto silentID = m.getMDKindID( reduction::silentTag );
-        llvm::DataLayout dl( &m );
+        _silentID = m.getMDKindID( reduction::silentTag );
+        _dl.emplace( &m );
 
         LowerAnnotations( Interrupt::local_skipmem ).run( m );
-        auto skip = util::functions_with_attr( Interrupt::local_skipmem, m );
-
-        for ( auto &fn : m )
-        {
-            if ( fn.empty() || skip.count( &fn ) )
-                continue;
-            annotateFn( fn, dl, silentID );
-        }
+        _skip = util::functions_with_attr( Interrupt::local_skipmem, m );
+        return true;
     }
 
+    void run( llvm::Module &m ) { runFunctionLocal( *this, m ); }
+
     std::string _handler_name;
     llvm::Function *_hypercall, *_handler;
+    std::set< llvm::Function * > _skip;
+    std::optional< llvm::DataLayout > _dl;
+    unsigned _silentID = 0;
     long _mem = 0;
 };
 
@@ -11,6 +11,7 @@
 #include <lart/support/annotate.h>
 
 #include <iostream>
+#include <thread>
 
 DIVINE_RELAX_WARNINGS
 #include <llvm/Support/MemoryBuffer.h>
@@ -109,9 +110,12 @@ struct Driver {
     void process( llvm::Module *m )
     {
         for ( auto &p : ps )
-            p->run( *m );
+            p->run( *m, jobs );
     }
 
+    /* the number of threads available to function-local passes */
+    unsigned jobs = std::max( 1u, std::thread::hardware_concurrency() );
+
   private:
     static void insertPasses( std::vector< PassMeta > &out, std::vector< PassMeta > &&toadd ) {
         std::copy( toadd.begin(), toadd.end(), std::back_inserter( out ) );
@@ -5,6 +5,10 @@
 DIVINE_RELAX_WARNINGS
 #include <llvm/IR/Module.h>
 DIVINE_UNRELAX_WARNINGS
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #ifndef LART_SUPPORT_PASS_H
@@ -15,9 +19,81 @@ namespace lart {
 struct Pass
 {
     virtual void run( llvm::Module &m ) = 0;
+    /* function-local passes (see below) use up to `jobs` threads, other
+     * passes simply run on the calling thread */
+    virtual void run( llvm::Module &m, unsigned /* jobs */ ) { run( m ); }
     virtual ~Pass() { };
 };
 
+/* A function-local pass is split into three phases:
+ *
+ *  - setup( Module & ) runs once, before any function is processed, and
+ *    returns false if the pass has nothing to do in this module,
+ *  - analyse( Function & ) computes whatever the pass needs to know about a
+ *    single function and must not change anything, neither in the module nor
+ *    in the LLVMContext (no new types, constants or metadata) -- this is the
+ *    part which runs in parallel,
+ *  - transform( Function &, Result ) then changes the function based on the
+ *    result of its analysis; since LLVM does not allow concurrent changes
+ *    within a single context, this runs sequentially, in module order.
+ *
+ * Passes which do not follow this shape are barriers: they run alone, after
+ * everything scheduled before them is done. */
+
+template< typename P >
+using analysis_t = decltype( std::declval< P & >().analyse( std::declval< llvm::Function & >() ) );
+
+template< typename P, typename = void >
+struct is_function_local : std::false_type {};
+
+template< typename P >
+struct is_function_local< P, std::void_t< analysis_t< P > > > : std::true_type {};
+
+template< typename P >
+void runFunctionLocal( P &pass, llvm::Module &m, unsigned jobs = 1 )
+{
+    if ( !pass.setup( m ) )
+        return;
+
+    std::vector< llvm::Function * > fns;
+    for ( auto &fn : m )
+        fns.push_back( &fn );
+
+    std::vector< analysis_t< P > > results( fns.size() );
+    std::vector< std::exception_ptr > errors( fns.size() );
+    std::atomic< size_t > next{ 0 };
+
+    /* an exception must not escape a thread: keep it until all the workers
+     * are joined and then rethrow the first one */
+    auto worker = [&]
+    {
+        for ( size_t i = next++; i < fns.size(); i = next++ )
+            try
+            {
+                results[ i ] = pass.analyse( *fns[ i ] );
+            }
+            catch ( ... )
+            {
+                errors[ i ] = std::current_exception();
+            }
+    };
+
+    jobs = std::min( size_t( jobs ), fns.size() / 16 ); /* not worth it for small modules */
+    std::vector< std::thread > threads;
+    for ( unsigned i = 1; i < jobs; ++i )
+        threads.emplace_back( worker );
+    worker();
+    for ( auto &t : threads )
+        t.join();
+
+    for ( auto &e : errors )
+        if ( e )
+            std::rethrow_exception( e );
+
+    for ( size_t i = 0; i < fns.size(); ++i )
+        pass.transform( *fns[ i ], std::move( results[ i ] ) );
+}
+
 namespace detail {
 
 template< typename T >
@@ -29,6 +105,14 @@ struct PassWrapper : Pass, T
     {
         T::run( m );
     }
+
+    void run( llvm::Module &m, unsigned jobs ) override
+    {
+        if constexpr ( is_function_local< T >::value )
+            runFunctionLocal< T >( *this, m, jobs );
+        else
+            T::run( m );
+    }
 };
 
 } // namespace detail
@@ -6,8 +6,11 @@
 #include <atomic>
 #include <sys/monitor.h>
 
+/* the plain scheduler with an explicit config is unfair; without one, the
+ * search itself only accepts cycles which are fair towards the tasks */
 // V: unfair V_OPT: --dios-config default
 // V: fair   V_OPT: --dios-config fair
+// V: fair_search
 
 bool checkX();
 void __buchi_accept();
@@ -0,0 +1,27 @@
+. lib/testcase
+
+cat > good.c <<EOF
+int main() { return 0; }
+EOF
+
+cat > bad.c <<EOF
+#include <assert.h>
+int main() { assert( 0 ); }
+EOF
+
+sock=$(mktemp -u /tmp/divine-serve.XXXXXX) # the work directory may be too long
+divine serve --socket $sock --threads 2 2> serve.log &
+server=$!
+trap "kill $server; rm -f $sock; check debris; test -e warning && exit 201" EXIT
+
+for i in $(seq 1 300); do test -S $sock && break; sleep 0.1; done
+test -S $sock
+
+divine submit --socket $sock verify good.c > good.out
+grep "error found: no" good.out
+
+divine submit --socket $sock verify --threads 0 bad.c > bad.out
+grep "error found: yes" bad.out
+
+not divine submit --socket $sock verify nonexistent.c > missing.out 2>&1
+grep ERROR missing.out
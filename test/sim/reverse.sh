@@ -0,0 +1,65 @@
+# TAGS: min
+. lib/testcase
+
+cat > file.cpp <<EOF
+int main() {
+    volatile int x = 1;
+    x = 2;
+    x = 3;
+    x = 4;
+    return x;
+}
+EOF
+
+sim file.cpp <<EOF
++ ^# executing __boot at
+> start
++ ^# executing main
+> step --count 3
++ ^# executing main at .*file.cpp:5
+> show .x
++ value:\s*\[i32 3 d\]
+> reverse-step
+> show
++ location:\s*.*file.cpp:4
+> show .x
++ value:\s*\[i32 2 d\]
+> reverse-step --count 2
+> show
++ location:\s*.*file.cpp:2
+> step
++ ^# executing main at .*file.cpp:3
+> show .x
++ value:\s*\[i32 1 d\]
+EOF
+
+sim file.cpp <<EOF
++ ^# executing __boot at
+> start
++ ^# executing main
+> step --count 2
++ ^# executing main at .*file.cpp:4
+> reverse-stepi
+> show
++ location:\s*.*file.cpp:3
+> stepi
+> show
++ location:\s*.*file.cpp:4
+> show .x
++ value:\s*\[i32 2 d\]
+EOF
+
+sim file.cpp <<EOF
++ ^# executing __boot at
+> start
++ ^# executing main
+> step --count 3
++ ^# executing main at .*file.cpp:5
+> break file.cpp:3
+> reverse-continue
++ ^# stopped at breakpoint file.cpp:3
+> show
++ location:\s*.*file.cpp:3
+> show .x
++ value:\s*\[i32 1 d\]
+EOF
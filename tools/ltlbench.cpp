@@ -0,0 +1,146 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Translate each formula of a corpus (a text file with one formula per line,
+ * where empty lines and lines starting with # are ignored, like the RERS
+ * property files) into an automaton, and report the time taken and the size
+ * of the automata, with and without the post-translation reductions. */
+
+#include <divine/ltl/buchi.hpp>
+#include <brick-cmd>
+#include <brick-except>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace divine;
+using clock_type = std::chrono::steady_clock;
+
+struct Stats
+{
+    size_t states = 0, transitions = 0, max_states = 0;
+    double time = 0, max_time = 0;
+
+    void add( const ltl::TGBA2 &a, double t )
+    {
+        size_t trans = 0;
+        for ( auto &s : a.states )
+            trans += s.size();
+        states += a.states.size(), transitions += trans;
+        max_states = std::max( max_states, a.states.size() );
+        time += t, max_time = std::max( max_time, t );
+    }
+
+    void report( std::ostream &o, std::string name, size_t count )
+    {
+        o << name << ":" << std::endl
+          << "  states: " << states << " (max " << max_states << "), transitions: " << transitions << std::endl
+          << "  time [ms]: total " << std::fixed << std::setprecision( 3 ) << time * 1000
+          << ", mean " << ( count ? time * 1000 / count : 0 ) << ", max " << max_time * 1000 << std::endl;
+    }
+};
+
+struct translate : brq::cmd_base
+{
+    brq::cmd_file _corpus;
+    brq::cmd_flag _rers, _negate, _verbose;
+    int _repeat = 1;
+
+    std::string_view help() override
+    {
+        return "Translate all formulae from the given corpus, both with and without the\n"
+               "reductions of the resulting automata, and report the totals.";
+    }
+
+    void options( brq::cmd_options &c ) override
+    {
+        brq::cmd_base::options( c );
+        c.opt( "--rers", _rers ) << "the formulae use the RERS syntax (uppercase atoms)";
+        c.opt( "--negate", _negate ) << "translate negated formulae (as for verification)";
+        c.opt( "--repeat", _repeat ) << "translate each formula this many times [1]";
+        c.opt( "--verbose", _verbose ) << "print the automaton sizes for each formula";
+        c.pos( _corpus );
+    }
+
+    std::vector< std::string > load()
+    {
+        std::ifstream in( _corpus.name );
+        if ( !in )
+            brq::raise() << "could not open " << _corpus.name;
+
+        std::vector< std::string > rv;
+        for ( std::string line; std::getline( in, line ); )
+            if ( !line.empty() && line[ 0 ] != '#' )
+                rv.push_back( line );
+        return rv;
+    }
+
+    template< typename F >
+    double timed( F f )
+    {
+        auto start = clock_type::now();
+        for ( int i = 0; i < _repeat; ++i )
+            f();
+        std::chrono::duration< double > t = clock_type::now() - start;
+        return t.count() / _repeat;
+    }
+
+    void run() override
+    {
+        auto formulae = load();
+        if ( formulae.empty() )
+            brq::raise() << "the corpus " << _corpus.name << " is empty";
+
+        Stats full, reduced;
+        double parse = 0;
+
+        for ( auto &f : formulae )
+        {
+            ltl::LTLPtr formula;
+            ltl::TGBA2 a, r;
+
+            parse += timed( [&] { formula = ltl::LTL::parse( f, _rers ); } );
+            full.add( a, timed( [&] { a = ltl::ltlToTGBA2( formula, _negate, false ); } ) );
+            reduced.add( r, timed( [&] { r = ltl::ltlToTGBA2( formula, _negate ); } ) );
+
+            if ( _verbose )
+                std::cout << a.states.size() << " → " << r.states.size() << " states: " << f << std::endl;
+        }
+
+        std::cout << "formulae: " << formulae.size() << ", parsing: " << std::fixed
+                  << std::setprecision( 3 ) << parse * 1000 << " ms" << std::endl;
+        full.report( std::cout, "translation", formulae.size() );
+        reduced.report( std::cout, "translation with reductions", formulae.size() );
+    }
+};
+
+int main( int argc, const char **argv ) try
+{
+    brq::cmd_parser parser( argc, argv, "Benchmark the LTL to automaton translation." );
+    auto cmd = parser.parse< translate >();
+    cmd.match( [&]( brq::cmd_help &help ) { help.run(); },
+               [&]( brq::cmd_base &c ) { c.run(); } );
+    return 0;
+}
+catch ( brq::error &e )
+{
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return e._exit;
+}
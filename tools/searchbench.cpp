@@ -0,0 +1,202 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Measure how the parallel search scales with the number of threads, on a
+ * synthetic state space which stresses memory the same way a real one does:
+ * the states are blobs allocated from a brick::mem::Pool and deduplicated by
+ * their content in a shared brq::concurrent_hash_set (cf. mc::Builder), but
+ * computing the successors is almost free. The search is repeated with 1, 2,
+ * 4, ... threads and the throughput of each run is reported, along with the
+ * speedup over a single thread. */
+
+#include <divine/ss/search.hpp>
+#include <brick-cmd>
+#include <brick-except>
+#include <brick-mem>
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+using namespace divine;
+using clock_type = std::chrono::steady_clock;
+
+/* the hash set needs some tag bits in the pointers (cf. mem::PoolRep) */
+struct PoolRep
+{
+    static const int slab_bits = 20, chunk_bits = 16, tag_bits = 28;
+    uint64_t slab:slab_bits, chunk:chunk_bits, tag:tag_bits;
+};
+
+struct Synthetic
+{
+    using Pool = brick::mem::Pool< PoolRep >;
+    using State = Pool::Pointer;
+    using Label = int;
+
+    struct Adaptor : brq::hash_adaptor< State >
+    {
+        Pool *_pool;
+        Adaptor( Pool &p ) : _pool( &p ) {}
+
+        const uint8_t *bytes( State s ) const
+        {
+            return reinterpret_cast< const uint8_t * >( _pool->dereference( s ) );
+        }
+
+        brq::hash64_t hash( State s ) const { return brq::hash( bytes( s ), _pool->size( s ) ); }
+
+        template< typename cell >
+        typename cell::pointer match( cell &c, State s, brq::hash64_t h ) const
+        {
+            if ( !c.match( h ) )
+                return nullptr;
+            auto t = c.fetch();
+            int size = _pool->size( s );
+            return _pool->size( t ) == size && !std::memcmp( bytes( t ), bytes( s ), size )
+                ? c.value() : nullptr;
+        }
+    };
+
+    Pool _pool;
+    brq::concurrent_hash_set< State > _states;
+    int64_t _count;
+    int _size, _branching;
+
+    Synthetic( int64_t count, int size, int branching )
+        : _count( count ), _size( size ), _branching( branching )
+    {}
+
+    State make( int64_t id )
+    {
+        auto s = _pool.allocate( _size );
+        auto *words = _pool.machinePointer< uint64_t >( s );
+        for ( int i = 0; i < _size / 8; ++i )
+            words[ i ] = id ^ ( uint64_t( i ) << 40 );
+        return s;
+    }
+
+    template< typename Y >
+    void edges( State from, Y yield )
+    {
+        int64_t id = *_pool.machinePointer< uint64_t >( from );
+        for ( int k = 0; k < _branching; ++k )
+        {
+            auto to = make( brq::hash( id, k ) % _count );
+            auto r = _states.insert( to, Adaptor( _pool ) );
+            if ( !r.isnew() )
+                _pool.free( to );
+            yield( r->load(), 0, r.isnew() );
+        }
+    }
+
+    template< typename Y >
+    void initials( Y yield )
+    {
+        auto s = make( 0 );
+        _states.insert( s, Adaptor( _pool ) );
+        yield( s );
+    }
+};
+
+struct scaling : brq::cmd_base
+{
+    int64_t _states = 1 << 22;
+    int _size = 64, _branching = 4, _max_threads = 0;
+    brq::cmd_flag _no_pin;
+
+    std::string_view help() override
+    {
+        return "Run a synthetic search with an increasing number of threads and report\n"
+               "the throughput and the speedup over a single thread.";
+    }
+
+    void options( brq::cmd_options &c ) override
+    {
+        brq::cmd_base::options( c );
+        c.opt( "--states", _states ) << "the number of states in the state space [4M]";
+        c.opt( "--size", _size ) << "the size of a single state in bytes [64]";
+        c.opt( "--branching", _branching ) << "the number of successors of each state [4]";
+        c.opt( "--max-threads", _max_threads ) << "stop after this many threads [all cores]";
+        c.opt( "--no-pin", _no_pin ) << "do not pin the worker threads to NUMA nodes";
+    }
+
+    std::pair< int64_t, double > search( int threads )
+    {
+        Synthetic ss( _states, std::max( 8, _size ), _branching );
+        std::atomic< int64_t > count( 0 );
+
+        auto search = ss::make_search( ss, ss::passive_listen(
+            [&]( auto, auto, auto, bool isnew )
+            {
+                if ( isnew )
+                    count.fetch_add( 1, std::memory_order_relaxed );
+            } ) );
+
+        auto start = clock_type::now();
+        search.start( threads );
+        search.wait();
+        std::chrono::duration< double > t = clock_type::now() - start;
+        return { count.load() + 1, t.count() };
+    }
+
+    void run() override
+    {
+        if ( !_max_threads )
+            _max_threads = std::max( 1u, std::thread::hardware_concurrency() );
+        brick::shmem::numa::pinning = !_no_pin;
+
+        auto &topo = brick::shmem::numa::topology();
+        std::cout << "numa nodes:";
+        for ( size_t n = 0; n < topo.nodes.size(); ++n )
+            std::cout << " " << topo.nodes[ n ] << " (" << topo.cpus[ n ].size() << " cpus)";
+        std::cout << std::endl << "pinning: " << ( _no_pin ? "no" : "beyond the cpus of one node" ) << std::endl;
+
+        double base = 0;
+        for ( int threads = 1; ; threads = std::min( 2 * threads, _max_threads ) )
+        {
+            auto [ states, time ] = search( threads );
+            double rate = states / time;
+            if ( threads == 1 )
+                base = rate;
+
+            std::cout << std::setw( 4 ) << threads << " threads: " << states << " states in "
+                      << std::fixed << std::setprecision( 3 ) << time << " s, "
+                      << std::setprecision( 0 ) << rate << " states/s, speedup "
+                      << std::setprecision( 2 ) << rate / base << std::endl;
+
+            if ( threads == _max_threads )
+                break;
+        }
+    }
+};
+
+int main( int argc, const char **argv ) try
+{
+    brq::cmd_parser parser( argc, argv, "Benchmark the scaling of the parallel search." );
+    auto cmd = parser.parse< scaling >();
+    cmd.match( [&]( brq::cmd_help &help ) { help.run(); },
+               [&]( brq::cmd_base &c ) { c.run(); } );
+    return 0;
+}
+catch ( brq::error &e )
+{
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return e._exit;
+}
@@ -0,0 +1,232 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+/*
+ * (c) 2020 Petr Ročkai <code@fixp.eu>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Replay a query corpus (recorded with `divine verify --smt-corpus`) against
+ * one or more solver backends and report throughput and latency. */
+
+#include <divine/smt/solver.hpp>
+#include <divine/smt/corpus.hpp>
+#include <brick-cmd>
+#include <brick-string>
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace divine;
+using namespace std::literals;
+namespace corpus = smt::corpus;
+using smt::solver::Result;
+
+struct Stats
+{
+    std::vector< uint64_t > nanos;
+    int sat = 0, unsat = 0, unknown = 0, mismatch = 0;
+
+    void add( const corpus::Query &q, Result r, uint64_t t )
+    {
+        nanos.push_back( t );
+        switch ( r )
+        {
+            case Result::True:    ++ sat; break;
+            case Result::False:   ++ unsat; break;
+            case Result::Unknown: ++ unknown; break;
+        }
+        auto recorded = Result( q.result );
+        if ( r != Result::Unknown && recorded != Result::Unknown && r != recorded )
+            ++ mismatch;
+    }
+
+    void merge( const Stats &o )
+    {
+        nanos.insert( nanos.end(), o.nanos.begin(), o.nanos.end() );
+        sat += o.sat, unsat += o.unsat, unknown += o.unknown, mismatch += o.mismatch;
+    }
+
+    double quantile( double q ) const
+    {
+        if ( nanos.empty() )
+            return 0;
+        return nanos[ std::min( nanos.size() - 1, size_t( q * nanos.size() ) ) ] / 1000.0;
+    }
+
+    void report( std::ostream &o, std::string name, double wall )
+    {
+        std::sort( nanos.begin(), nanos.end() );
+        uint64_t total = 0;
+        for ( auto n : nanos )
+            total += n;
+
+        o << name << ":" << std::endl
+          << "  queries: " << nanos.size()
+          << " (sat " << sat << ", unsat " << unsat << ", unknown " << unknown << ")" << std::endl
+          << "  wall time: " << std::fixed << std::setprecision( 3 ) << wall << " s, "
+          << "throughput: " << std::setprecision( 1 ) << ( wall > 0 ? nanos.size() / wall : 0 ) << " q/s" << std::endl
+          << "  latency [μs]: mean " << ( nanos.empty() ? 0 : total / 1000.0 / nanos.size() )
+          << ", p50 " << quantile( .5 ) << ", p90 " << quantile( .9 )
+          << ", p99 " << quantile( .99 ) << ", max " << quantile( 1 ) << std::endl;
+        if ( mismatch )
+            o << "  WARNING: " << mismatch << " results differ from the recorded ones" << std::endl;
+    }
+};
+
+struct command : brq::cmd_base
+{
+    brq::cmd_file _corpus;
+    std::vector< corpus::Query > _queries;
+
+    void load() { _queries = corpus::Reader( _corpus.name ).load(); }
+
+    void options( brq::cmd_options &c ) override
+    {
+        brq::cmd_base::options( c );
+        c.pos( _corpus );
+    }
+};
+
+struct info : command
+{
+    void run() override
+    {
+        load();
+        Stats stats[ corpus::kinds ];
+        double time[ corpus::kinds ] = { 0, 0, 0 };
+        const char *name[ corpus::kinds ] = { "feasibility", "equality", "subsumption" };
+
+        for ( auto &q : _queries )
+        {
+            int k = int( q.kind );
+            stats[ k ].add( q, Result( q.result ), q.nanos );
+            time[ k ] += q.nanos / 1e9;
+        }
+
+        for ( int k = 0; k < corpus::kinds; ++k )
+            if ( !stats[ k ].nanos.empty() )
+                stats[ k ].report( std::cout, name[ k ] + " (as recorded)"s, time[ k ] );
+    }
+};
+
+struct replay : command
+{
+    std::vector< std::string > _solvers;
+    int _threads = 1, _repeat = 1;
+
+    std::string_view help() override
+    {
+        return "Replay all queries stored in the given corpus against each of the given solvers\n"
+               "(z3, stp, smtlib or smtlib:<command>). Queries are distributed over the worker\n"
+               "threads, each of which owns a separate solver instance.";
+    }
+
+    void options( brq::cmd_options &c ) override
+    {
+        command::options( c );
+        c.opt( "--solver", _solvers ) << "a solver to benchmark (can be repeated) [z3]";
+        c.opt( "--threads", _threads ) << "number of worker threads [1]";
+        c.opt( "--repeat", _repeat ) << "replay the corpus this many times [1]";
+    }
+
+    template< typename solver_t, typename... args_t >
+    void bench( std::string name, args_t... args )
+    {
+        std::atomic< size_t > next( 0 );
+        size_t total = _queries.size() * _repeat;
+        std::vector< Stats > stats( _threads );
+        std::vector< std::thread > workers;
+
+        auto start = corpus::clock::now();
+
+        for ( int i = 0; i < _threads; ++i )
+            workers.emplace_back( [&, i]
+            {
+                solver_t solver( args... );
+                for ( size_t n = next++; n < total; n = next++ )
+                {
+                    auto &q = _queries[ n % _queries.size() ];
+                    auto t = corpus::clock::now();
+                    auto r = solver.replay( q );
+                    auto d = corpus::clock::now() - t;
+                    stats[ i ].add( q, r, std::chrono::duration_cast< std::chrono::nanoseconds >( d ).count() );
+                }
+            } );
+
+        for ( auto &w : workers )
+            w.join();
+
+        std::chrono::duration< double > wall = corpus::clock::now() - start;
+        for ( int i = 1; i < _threads; ++i )
+            stats[ 0 ].merge( stats[ i ] );
+        stats[ 0 ].report( std::cout, name, wall.count() );
+    }
+
+    void run() override
+    {
+        load();
+        if ( _queries.empty() )
+            brq::raise() << "the corpus " << _corpus.name << " is empty";
+        if ( _solvers.empty() )
+            _solvers.push_back( "z3" );
+
+        for ( auto s : _solvers )
+        {
+#if OPT_Z3
+            if ( s == "z3" )
+            {
+                bench< smt::solver::Simple< smt::solver::Z3 > >( s );
+                continue;
+            }
+#endif
+#if OPT_STP
+            if ( s == "stp" )
+            {
+                bench< smt::solver::Simple< smt::solver::STP > >( s );
+                continue;
+            }
+#endif
+            if ( brq::starts_with( s, "smtlib" ) )
+            {
+                std::vector< std::string > cmd;
+                if ( s == "smtlib" || s == "smtlib:z3" )
+                    cmd = { "z3", "-in", "-smt2" };
+                else if ( s == "smtlib:boolector" )
+                    cmd = { "boolector", "--smt2" };
+                else
+                    cmd = { std::string( s, 7, std::string::npos ) };
+                bench< smt::solver::Simple< smt::solver::SMTLib > >( s, cmd );
+                continue;
+            }
+
+            brq::raise() << "unsupported solver " << s;
+        }
+    }
+};
+
+int main( int argc, const char **argv ) try
+{
+    brq::cmd_parser parser( argc, argv, "Replay recorded SMT queries for solver benchmarking." );
+    auto cmd = parser.parse< info, replay >();
+    cmd.match( [&]( brq::cmd_help &help ) { help.run(); },
+               [&]( command &c ) { c.run(); } );
+    return 0;
+}
+catch ( brq::error &e )
+{
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return e._exit;
+}